@@ -0,0 +1,120 @@
+import os
+import sys
+import argparse
+import random
+import re
+import subprocess
+import time
+
+
+# Some constants
+NUM_CHANNELS = 32
+NUM_BANKS = 16
+NUM_ROWS = 1 << 14
+RANDOM_SEED = 0
+
+
+def parse_arg():
+  parser = argparse.ArgumentParser(
+    description="Time the FRFCFS scheduler of the AiM controller with deep host read/write buffers."
+  )
+
+  parser.add_argument(
+    "--ramulator", type=str, dest="ramulator",
+    default="../build/ramulator2",
+    help="Path to the ramulator2 executable."
+  )
+
+  parser.add_argument(
+    "--config", type=str, dest="config",
+    default="../test/example.yaml",
+    help="AiM configuration to run."
+  )
+
+  parser.add_argument(
+    "--sizes", type=int, nargs="+", dest="sizes",
+    default=[32, 64, 128, 256, 512],
+    help="Read/write buffer sizes (MemorySystem.Controller.buffer_size) to sweep."
+  )
+
+  parser.add_argument(
+    "--num_reqs", "-n", type=int, dest="num_reqs",
+    default=200000,
+    help="The number of host memory requests in the trace."
+  )
+
+  parser.add_argument(
+    "--ratio", "-r", type=float, dest="rw_ratio",
+    default=0.8,
+    help="The ratio of the number of memory read vs write requests."
+  )
+
+  parser.add_argument(
+    "--channels", type=int, dest="num_channels",
+    default=1,
+    help="Number of channels that the requests are spread over (fewer channels fill deeper buffers)."
+  )
+
+  parser.add_argument(
+    "--hot_rows", type=int, dest="hot_rows",
+    default=4,
+    help="Rows per bank that the requests are spread over (fewer rows give more row hits)."
+  )
+
+  parser.add_argument(
+    "--itrs", type=int, dest="num_itrs",
+    default=3,
+    help="Number of runs per buffer size."
+  )
+
+  return parser.parse_args()
+
+
+def gen_trace(path, num_reqs, rw_ratio, num_channels, hot_rows):
+  random.seed(RANDOM_SEED)
+  bank_rows = [random.sample(range(NUM_ROWS), hot_rows) for _ in range(NUM_BANKS)]
+  with open(path, "w") as f:
+    for _ in range(num_reqs):
+      req_type = "R" if random.random() < rw_ratio else "W"
+      channel = random.randrange(num_channels)
+      bank = random.randrange(NUM_BANKS)
+      row = random.choice(bank_rows[bank])
+      f.write(f"{req_type} MEM {channel} {bank} {row}\n")
+    f.write("AiM EOC\n")
+
+
+def time_execution(args):
+  print(f"Running {args}...")
+  start_time = time.time()
+  r = subprocess.run(args, capture_output = True, text = True)
+  end_time = time.time()
+
+  elapsed = end_time - start_time
+  return elapsed, r
+
+
+def main():
+  args = parse_arg()
+  num_channels = min(args.num_channels, NUM_CHANNELS)
+  trace = f"./host_rw_{args.num_reqs}_{num_channels}ch_{args.hot_rows}rows.trace"
+  if not os.path.exists(trace):
+    gen_trace(trace, args.num_reqs, args.rw_ratio, num_channels, args.hot_rows)
+
+  print("buffer_size,itr,elapsed_time,memory_system_cycles")
+  for size in args.sizes:
+    for itr in range(args.num_itrs):
+      elapsed, r = time_execution([
+        args.ramulator,
+        "-f", args.config,
+        "-t", trace,
+        "-p", f"MemorySystem.Controller.buffer_size={size}",
+      ])
+      if r.returncode != 0:
+        print(r.stdout, r.stderr, file=sys.stderr)
+        exit(-1)
+      cycles = re.search(r"memory_system_cycles:\s*(\d+)", r.stdout)
+      print(f"{size},{itr},{elapsed:.3f},{cycles.group(1) if cycles else 'NA'}")
+
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,86 @@
+import os
+import sys
+import argparse
+import glob
+import re
+import resource
+import subprocess
+
+
+def parse_arg():
+  parser = argparse.ArgumentParser(
+    description="Compare the simulation time of ramulator2 builds on the AiM microtraces."
+  )
+
+  parser.add_argument(
+    "--ramulator", type=str, nargs="+", dest="ramulators",
+    default=["../build/ramulator2"],
+    help="Paths to the ramulator2 executables to compare; the first one is the reference."
+  )
+
+  parser.add_argument(
+    "--config", type=str, dest="config",
+    default="../test/example.yaml",
+    help="AiM configuration to run."
+  )
+
+  parser.add_argument(
+    "--traces", type=str, nargs="+", dest="traces",
+    default=sorted(glob.glob("../test/micro_*.trace")),
+    help="Traces to run."
+  )
+
+  parser.add_argument(
+    "--itrs", type=int, dest="num_itrs",
+    default=5,
+    help="Number of runs per executable and trace (the fastest one is reported)."
+  )
+
+  return parser.parse_args()
+
+
+def time_execution(args):
+  # User + system time of the child, which is less noisy than the wall-clock time
+  before = resource.getrusage(resource.RUSAGE_CHILDREN)
+  r = subprocess.run(args, capture_output = True, text = True)
+  after = resource.getrusage(resource.RUSAGE_CHILDREN)
+
+  elapsed = (after.ru_utime - before.ru_utime) + (after.ru_stime - before.ru_stime)
+  return elapsed, r
+
+
+def main():
+  args = parse_arg()
+
+  print("trace,ramulator,itr,cpu_time,memory_system_cycles")
+  best = {}
+  for trace in args.traces:
+    cycles = {}
+    # Interleave the executables, so that a change in machine load hits all of them alike
+    for itr in range(args.num_itrs):
+      for ramulator in args.ramulators:
+        elapsed, r = time_execution([ramulator, "-f", args.config, "-t", trace])
+        if r.returncode != 0:
+          print(r.stdout, r.stderr, file=sys.stderr)
+          exit(-1)
+        match = re.search(r"memory_system_cycles:\s*(\d+)", r.stdout)
+        cycles[ramulator] = match.group(1) if match else "NA"
+        best[(trace, ramulator)] = min(best.get((trace, ramulator), elapsed), elapsed)
+        print(f"{os.path.basename(trace)},{ramulator},{itr},{elapsed:.3f},{cycles[ramulator]}")
+
+    if len(set(cycles.values())) != 1:
+      print(f"The executables simulate {trace} differently: {cycles}", file=sys.stderr)
+      exit(-1)
+
+  print()
+  print("trace," + ",".join(args.ramulators) + (",speedup" if len(args.ramulators) > 1 else ""))
+  for trace in args.traces:
+    times = [best[(trace, ramulator)] for ramulator in args.ramulators]
+    line = f"{os.path.basename(trace)}," + ",".join(f"{t:.3f}" for t in times)
+    if len(times) > 1:
+      line += "," + ",".join(f"{times[0] / t:.3f}" for t in times[1:])
+    print(line)
+
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "base/base.h"
+#include "base/config.h"
+#include "base/request.h"
+#include "dram/dram.h"
+#include "dram_controller/bank_tracker.h"
+#include "memory_system/memory_system.h"
+
+std::map<std::string, Ramulator::AiMISR> Ramulator::AiMISRInfo::opcode_str_to_aim_ISR;
+std::map<Ramulator::Opcode, std::string> Ramulator::AiMISRInfo::aim_opcode_to_str;
+
+std::map<std::string, Ramulator::Type> Ramulator::AiMISRInfo::str_to_type;
+std::map<Ramulator::Type, std::string> Ramulator::AiMISRInfo::type_to_str;
+
+std::map<std::string, Ramulator::MemAccessRegion> Ramulator::AiMISRInfo::str_to_mem_access_region;
+std::map<Ramulator::MemAccessRegion, std::string> Ramulator::AiMISRInfo::mem_access_region_to_str;
+
+std::string Ramulator::trace_file_path;
+bool Ramulator::use_trace_file_path;
+
+using namespace Ramulator;
+
+// Some constants
+constexpr int NUM_REQS = 1 << 16;            // Distinct requests that are activated and checked
+constexpr int NUM_CHECKS = 2000000;          // Checks timed per depth
+constexpr int NUM_REPEATS = 5;               // Runs per depth, the fastest one is reported
+constexpr float AIM_MULTI_BANK_RATIO = 0.1f; // AiM requests that target all banks of the channel
+constexpr int RANDOM_SEED = 0;
+
+struct Workload {
+    std::vector<Request> activated; // Requests that enter the active buffer, in order
+    std::vector<Request> closing;   // Requests whose closing command is checked
+};
+
+AddrVec_t generate_addr_vec(IDRAM *dram, std::mt19937 &rng, float multi_bank_ratio) {
+    int channel_idx = dram->m_levels("channel");
+    int row_idx = dram->m_levels("row");
+    AddrVec_t addr_vec(dram->m_levels.size(), 0);
+    bool is_multi_bank = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng) < multi_bank_ratio;
+    for (int level = channel_idx + 1; level < addr_vec.size(); level++) {
+        if (is_multi_bank && (level < row_idx)) {
+            addr_vec[level] = -1;
+        } else {
+            addr_vec[level] = std::uniform_int_distribution<int>(0, std::max(dram->m_organization.count[level], 1) - 1)(rng);
+        }
+    }
+    return addr_vec;
+}
+
+Workload generate_workload(IDRAM *dram, int num_reqs, float multi_bank_ratio, int seed) {
+    std::mt19937 rng(seed);
+    Workload workload;
+    for (int i = 0; i < num_reqs; i++) {
+        workload.activated.emplace_back(generate_addr_vec(dram, rng, multi_bank_ratio), (int)Type::Read);
+        workload.closing.emplace_back(generate_addr_vec(dram, rng, multi_bank_ratio), (int)Type::Read);
+    }
+    return workload;
+}
+
+// The check of the generic controller before ActiveBankTracker
+bool is_closing_started_row_generic(ReqBuffer &active_buffer, const Request &req, int row_addr_idx) {
+    bool is_conflict = false;
+    auto rowgroup_begin = req.addr_vec.begin();
+    auto rowgroup_end = rowgroup_begin + row_addr_idx;
+    for (auto _it = active_buffer.begin(); _it != active_buffer.end(); _it++) {
+        if (std::equal(rowgroup_begin, rowgroup_end, _it->addr_vec.begin())) {
+            is_conflict = true;
+        }
+    }
+    return is_conflict;
+}
+
+// The check of the AiM controller before ActiveBankTracker
+bool compare_addr_vec(const Request &req1, const Request &req2, int channel_addr_idx, int min_compared_level) {
+    for (int level_idx = channel_addr_idx; level_idx <= min_compared_level; level_idx++) {
+        if (req1.addr_vec[level_idx] == -1)
+            return true;
+        if (req2.addr_vec[level_idx] == -1)
+            return true;
+        if (req1.addr_vec[level_idx] != req2.addr_vec[level_idx])
+            return false;
+    }
+    return true;
+}
+
+bool is_closing_started_row_AiM(ReqBuffer &active_buffer, const Request &req, int channel_addr_idx, int row_addr_idx) {
+    for (auto _it = active_buffer.begin(); _it != active_buffer.end(); _it++) {
+        if (compare_addr_vec(req, *_it, channel_addr_idx, row_addr_idx - 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct Result {
+    double ns_per_check = 0.0;
+    int num_conflicts = 0;
+};
+
+/**
+ * @brief    Runs NUM_CHECKS checks with depth requests in the active buffer, returns the fastest of NUM_REPEATS runs
+ *
+ */
+template <typename Check_t>
+Result run(IDRAM *dram, const Workload &workload, int depth, bool use_tracker, Check_t &&check) {
+    Result best;
+    best.ns_per_check = std::numeric_limits<double>::max();
+    int num_reqs = workload.activated.size();
+    for (int repeat = 0; repeat < NUM_REPEATS; repeat++) {
+        ReqPool pool;
+        ReqBuffer active_buffer{pool};
+        active_buffer.max_size = std::numeric_limits<size_t>::max();
+        ActiveBankTracker active_banks;
+        active_banks.setup(dram);
+
+        int next = 0;
+        for (; next < depth; next++) {
+            active_buffer.enqueue(workload.activated[next % num_reqs]);
+            if (use_tracker) {
+                active_banks.add(workload.activated[next % num_reqs]);
+            }
+        }
+
+        Result result;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_CHECKS; i++) {
+            result.num_conflicts += check(active_buffer, active_banks, workload.closing[i % num_reqs]);
+
+            // Retire the oldest active request and activate the next one
+            if (depth != 0) {
+                auto oldest = active_buffer.begin();
+                if (use_tracker) {
+                    active_banks.remove(*oldest);
+                }
+                active_buffer.remove(oldest);
+                const Request &req = workload.activated[next++ % num_reqs];
+                if (use_tracker) {
+                    active_banks.add(req);
+                }
+                active_buffer.enqueue(req);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        result.ns_per_check = std::chrono::duration<double, std::nano>(end - start).count() / NUM_CHECKS;
+        if (result.ns_per_check < best.ns_per_check) {
+            best = result;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief    Times the row-closing conflict check of schedule_request() at a range of active-buffer depths
+ * @details
+ * Before a closing command is scheduled, the controller checks whether it would interrupt a request in the active
+ * buffer. This compares the scan of the active buffer that the controllers used to do (std::equal on the address
+ * prefix in the generic controller, the wildcard compare_addr_vec() in the AiM controller) with the per-bank counts of
+ * ActiveBankTracker. Every check is followed by retiring the oldest active request and activating a new one, so the
+ * tracker also pays for its updates.
+ *
+ * Usage: bank_tracker_bench [config_file] [depth ...]
+ *
+ */
+int main(int argc, char *argv[]) {
+    std::string config_file = (argc > 1) ? argv[1] : "test/example.yaml";
+    std::vector<int> depths = {1, 4, 8, 16, 32, 64, 128};
+    if (argc > 2) {
+        depths.clear();
+        for (int i = 2; i < argc; i++) {
+            depths.push_back(std::stoi(argv[i]));
+        }
+    }
+
+    AiMISRInfo::init();
+    YAML::Node config = Config::parse_config_file(config_file, {});
+    IMemorySystem *memory_system = Factory::create_memory_system(config);
+    IDRAM *dram = memory_system->get_ifce<IDRAM>();
+
+    int channel_addr_idx = dram->m_levels("channel");
+    int row_addr_idx = dram->m_levels("row");
+
+    // Requests of the generic controller always target a single bank, AiM requests may target all of them
+    Workload generic_workload = generate_workload(dram, NUM_REQS, 0.0f, RANDOM_SEED);
+    Workload AiM_workload = generate_workload(dram, NUM_REQS, AIM_MULTI_BANK_RATIO, RANDOM_SEED);
+
+    auto generic_scan = [&](ReqBuffer &active_buffer, ActiveBankTracker &, const Request &req) {
+        return is_closing_started_row_generic(active_buffer, req, row_addr_idx);
+    };
+    auto generic_tracker = [](ReqBuffer &, ActiveBankTracker &active_banks, const Request &req) {
+        return active_banks.is_bank_active(req.addr_vec);
+    };
+    auto AiM_scan = [&](ReqBuffer &active_buffer, ActiveBankTracker &, const Request &req) {
+        return is_closing_started_row_AiM(active_buffer, req, channel_addr_idx, row_addr_idx);
+    };
+    auto AiM_tracker = [](ReqBuffer &, ActiveBankTracker &active_banks, const Request &req) {
+        return active_banks.is_any_bank_active(req.addr_vec);
+    };
+
+    printf("ns per check (best of %d runs of %d checks)\n", NUM_REPEATS, NUM_CHECKS);
+    printf("%6s %14s %14s %14s %14s\n", "depth", "generic_scan", "generic_track", "AiM_scan", "AiM_track");
+    for (int depth : depths) {
+        Result results[4] = {
+            run(dram, generic_workload, depth, false, generic_scan),
+            run(dram, generic_workload, depth, true, generic_tracker),
+            run(dram, AiM_workload, depth, false, AiM_scan),
+            run(dram, AiM_workload, depth, true, AiM_tracker),
+        };
+        printf("%6d %14.2f %14.2f %14.2f %14.2f\n", depth, results[0].ns_per_check, results[1].ns_per_check, results[2].ns_per_check, results[3].ns_per_check);
+
+        // Both checks must find the same conflicts
+        if ((results[0].num_conflicts != results[1].num_conflicts) || (results[2].num_conflicts != results[3].num_conflicts)) {
+            spdlog::error("Depth {}: the scan and the tracker disagree (generic {} vs. {}, AiM {} vs. {} conflicts)!", depth,
+                          results[0].num_conflicts, results[1].num_conflicts, results[2].num_conflicts, results[3].num_conflicts);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/type.h"
+
+using namespace Ramulator;
+
+// Some constants
+constexpr int NUM_NODES = 16;       // Nodes at the level, e.g., the banks of a channel
+constexpr int NUM_CMDS = 26;        // Commands of the spec (GDDR6 AiM has 26)
+constexpr int NUM_ISSUES = 1 << 16; // Distinct (node, command) issues, replayed in a loop
+constexpr int NUM_TIMED_ISSUES = 50000000;
+constexpr int NUM_REPEATS = 5; // Runs per window, the fastest one is reported
+constexpr int RANDOM_SEED = 0;
+
+struct Issue {
+    int node;
+    int cmd;
+};
+
+/**
+ * @brief    The histories of every (node, command), as kept in the nodes before the timing tables
+ * @details
+ * Every node had one std::deque per command. Issuing a command popped the oldest issue and pushed the new one.
+ *
+ */
+struct DequeHistory {
+    std::vector<std::deque<Clk_t>> histories; // [node * NUM_CMDS + cmd]
+
+    explicit DequeHistory(int window) : histories(NUM_NODES * NUM_CMDS, std::deque<Clk_t>(window, -1)){};
+
+    Clk_t issue(int node, int cmd, Clk_t clk, int window) {
+        std::deque<Clk_t> &history = histories[node * NUM_CMDS + cmd];
+        history.pop_back();
+        history.push_front(clk);
+        return history[window - 1];
+    };
+};
+
+/**
+ * @brief    The histories in the timing table, most recent issue first
+ * @details
+ * Issuing a command shifted the whole window by one slot.
+ *
+ */
+struct ShiftHistory {
+    std::vector<Clk_t> histories; // [(node * NUM_CMDS + cmd) * window + i]
+
+    explicit ShiftHistory(int window) : histories(NUM_NODES * NUM_CMDS * window, -1){};
+
+    Clk_t issue(int node, int cmd, Clk_t clk, int window) {
+        Clk_t *history = histories.data() + (node * NUM_CMDS + cmd) * window;
+        std::copy_backward(history, history + window - 1, history + window);
+        history[0] = clk;
+        return history[window - 1];
+    };
+};
+
+/**
+ * @brief    The histories in the timing table as circular buffers (DRAMNodeBase::update_timing())
+ * @details
+ * Issuing a command moves the head back one slot and overwrites the oldest issue. The buffer of a window of W issues
+ * has bit_ceil(W) slots, so wrapping around is a mask.
+ *
+ */
+struct CircularHistory {
+    int width;
+    std::vector<Clk_t> histories; // [(node * NUM_CMDS + cmd) * width + i]
+    std::vector<int> heads;       // [node * NUM_CMDS + cmd]: Position of the most recent issue
+
+    explicit CircularHistory(int window) : width(std::bit_ceil((unsigned)window)), histories(NUM_NODES * NUM_CMDS * width, -1), heads(NUM_NODES * NUM_CMDS, 0){};
+
+    Clk_t issue(int node, int cmd, Clk_t clk, int window) {
+        Clk_t *history = histories.data() + (node * NUM_CMDS + cmd) * width;
+        int &head = heads[node * NUM_CMDS + cmd];
+        head = (head - 1) & (width - 1);
+        history[head] = clk;
+        return history[(head + window - 1) & (width - 1)];
+    };
+};
+
+/**
+ * @brief    Returns the ns per issue of the fastest of NUM_REPEATS runs
+ * @details
+ * Like a windowed constraint (e.g., nFAW), every issue reads the oldest issue in the window and pushes the ready
+ * clock of a following command.
+ *
+ */
+template <typename History_t>
+double run(const std::vector<Issue> &issues, int window, Clk_t &checksum) {
+    double best = std::numeric_limits<double>::max();
+    for (int repeat = 0; repeat < NUM_REPEATS; repeat++) {
+        History_t history(window);
+        std::vector<Clk_t> ready_clks(NUM_NODES * NUM_CMDS, -1);
+
+        auto start = std::chrono::steady_clock::now();
+        for (Clk_t clk = 0; clk < NUM_TIMED_ISSUES; clk++) {
+            const Issue &issue = issues[clk % NUM_ISSUES];
+            Clk_t past = history.issue(issue.node, issue.cmd, clk, window);
+            if (past >= 0) {
+                Clk_t &ready_clk = ready_clks[issue.node * NUM_CMDS + (issue.cmd + 1) % NUM_CMDS];
+                ready_clk = std::max(ready_clk, past + 20);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / NUM_TIMED_ISSUES);
+
+        checksum = 0;
+        for (Clk_t ready_clk : ready_clks) {
+            checksum += ready_clk;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief    Times the per-command cost of the command histories of the DRAM nodes
+ * @details
+ * Replays a random stream of (node, command) issues through the three layouts the histories have had: a std::deque
+ * per node and command, a shifted window in the timing table, and the circular buffer that DRAMNodeBase uses now.
+ *
+ * Usage: command_history_bench [window ...]
+ *
+ */
+int main(int argc, char *argv[]) {
+    std::vector<int> windows = {1, 2, 4, 8};
+    if (argc > 1) {
+        windows.clear();
+        for (int i = 1; i < argc; i++) {
+            windows.push_back(std::stoi(argv[i]));
+        }
+    }
+
+    std::mt19937 rng(RANDOM_SEED);
+    std::vector<Issue> issues;
+    for (int i = 0; i < NUM_ISSUES; i++) {
+        issues.push_back({std::uniform_int_distribution<int>(0, NUM_NODES - 1)(rng), std::uniform_int_distribution<int>(0, NUM_CMDS - 1)(rng)});
+    }
+
+    printf("ns per issue (best of %d runs of %d issues, %d nodes x %d commands)\n", NUM_REPEATS, NUM_TIMED_ISSUES, NUM_NODES, NUM_CMDS);
+    printf("%6s %10s %10s %10s\n", "window", "deque", "shift", "circular");
+    for (int window : windows) {
+        Clk_t checksums[3];
+        double deque_ns = run<DequeHistory>(issues, window, checksums[0]);
+        double shift_ns = run<ShiftHistory>(issues, window, checksums[1]);
+        double circular_ns = run<CircularHistory>(issues, window, checksums[2]);
+        printf("%6d %10.2f %10.2f %10.2f\n", window, deque_ns, shift_ns, circular_ns);
+
+        // All layouts must see the same past issues
+        if ((checksums[0] != checksums[1]) || (checksums[0] != checksums[2])) {
+            fprintf(stderr, "Window %d: the layouts disagree on the ready clocks!\n", window);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include "base/request.h"
 
+#include <algorithm>
+
 namespace Ramulator {
 
 Request::Request(Addr_t addr, int type_id) : addr(addr), type_id(type_id), type((Type)type_id) {};
@@ -14,26 +16,62 @@ bool Request::is_reader() {
             (AiMISRInfo::convert_AiM_opcode_to_AiM_ISR(opcode).AiM_DMA_blocking == true));
 }
 
-std::string Request::str() {
+ChannelMask ChannelMask::from_str(const std::string &str) {
+    ChannelMask mask;
+    if ((str.compare(0, 2, "0x") == 0) || (str.compare(0, 2, "0X") == 0)) {
+        // 16 hexadecimal digits per word, from the least significant ones
+        std::string digits = str.substr(2);
+        for (int end = digits.size(); end > 0; end -= 16) {
+            int begin = std::max(end - 16, 0);
+            mask.words.push_back(std::stoull(digits.substr(begin, end - begin), nullptr, 16));
+        }
+    } else {
+        mask.words.push_back(std::stoull(str));
+    }
+    return mask;
+}
+
+std::string ChannelMask::str() const {
+    std::stringstream mask_stream;
+    mask_stream << "0x" << std::hex;
+    for (int word_idx = (int)words.size() - 1; word_idx >= 0; word_idx--) {
+        if (word_idx != (int)words.size() - 1) {
+            mask_stream.width(16);
+            mask_stream.fill('0');
+        }
+        mask_stream << words[word_idx];
+    }
+    return mask_stream.str();
+}
+
+const AiMISRPayload &Request::isr() const {
+    static const AiMISRPayload empty_payload;
+    return payload ? *payload : empty_payload;
+}
+
+std::string Request::str() const {
     std::stringstream req_stream;
     if (type == Type::AIM) {
         req_stream << "Request[Type(" << AiMISRInfo::convert_AiM_opcode_to_str(opcode) << "), ";
-        if (opsize != -1)
-            req_stream << "Opsize(" << opsize << "), ";
-        if (GPR_addr_0 != -1)
-            req_stream << "GPR0(" << GPR_addr_0 << "), ";
-        if (GPR_addr_1 != -1)
-            req_stream << "GPR1(" << GPR_addr_1 << "), ";
-        if (channel_mask != -1)
-            req_stream << "CHMask(" << channel_mask << "), ";
-        if (bank_index != -1)
-            req_stream << "BA(" << bank_index << "), ";
-        if (row_addr != -1)
-            req_stream << "RO(" << row_addr << "), ";
-        if (col_addr != -1)
-            req_stream << "CO(" << col_addr << "), ";
-        if (thread_index != -1)
-            req_stream << "Tid(" << thread_index << "), ";
+        const AiMISRPayload &isr = this->isr();
+        if (isr.opsize != -1)
+            req_stream << "Opsize(" << isr.opsize << "), ";
+        if (isr.GPR_addr_0 != -1)
+            req_stream << "GPR0(" << isr.GPR_addr_0 << "), ";
+        if (isr.GPR_addr_1 != -1)
+            req_stream << "GPR1(" << isr.GPR_addr_1 << "), ";
+        if (isr.device_id != -1)
+            req_stream << "Device(" << isr.device_id << "), ";
+        if (isr.channel_mask.is_set())
+            req_stream << "CHMask(" << isr.channel_mask.str() << "), ";
+        if (isr.bank_index != -1)
+            req_stream << "BA(" << isr.bank_index << "), ";
+        if (isr.row_addr != -1)
+            req_stream << "RO(" << isr.row_addr << "), ";
+        if (isr.col_addr != -1)
+            req_stream << "CO(" << isr.col_addr << "), ";
+        if (isr.thread_index != -1)
+            req_stream << "Tid(" << isr.thread_index << "), ";
     } else {
         if (type == Type::Read) {
             req_stream << "Request[Type(Read), Region(";
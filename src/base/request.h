@@ -1,8 +1,11 @@
 #ifndef RAMULATOR_BASE_REQUEST_H
 #define RAMULATOR_BASE_REQUEST_H
 
-#include <list>
+#include <bit>
+#include <deque>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <stdint.h>
 #include <string>
 #include <vector>
@@ -60,19 +63,53 @@ enum class Opcode {
     // ISR_MAC_HBK,   // [NOT_IMPLEMENTED] Perform MAC operation between [8 banks] and [Global Buffer]
 };
 
-struct Request {
-    Addr_t addr = -1;
-    Data_t data;
-    AddrVec_t addr_vec{};
-    int host_req_id = -1;
-    int AiM_req_id = -1;
-
-    Type type = Type::MAX;
+/**
+ * @brief    Channels of an AiM device that an ISR targets, as a bitset of any width
+ * @details
+ * The trace gives it as a hexadecimal (0x...) or decimal number. Bits are counted from the least significant one,
+ * and bit i selects channel W - 1 - i of the device, where W is the number of channels of a device rounded up to a
+ * multiple of 32. With 32 channels, the most significant bit of a 32-bit mask is channel 0.
+ * 
+ */
+struct ChannelMask {
+    std::vector<uint64_t> words; // Bit i is bit i % 64 of words[i / 64]; empty if no mask is given
+
+    static ChannelMask from_str(const std::string &str);
+
+    bool is_set() const { return !words.empty(); };
+
+    int count() const {
+        int num_bits = 0;
+        for (uint64_t word : words) {
+            num_bits += std::popcount(word);
+        }
+        return num_bits;
+    };
 
-    MemAccessRegion mem_access_region = MemAccessRegion::MAX;
+    /**
+     * @brief    Calls func(bit) for every set bit, from the least significant one
+     * 
+     */
+    template <typename Func_t>
+    void for_each_bit(Func_t &&func) const {
+        for (int word_idx = 0; word_idx < words.size(); word_idx++) {
+            for (uint64_t word = words[word_idx]; word != 0; word &= word - 1) {
+                func(word_idx * 64 + std::countr_zero(word));
+            }
+        }
+    };
 
-    Opcode opcode = Opcode::MAX;
+    std::string str() const;
+};
 
+/**
+ * @brief    ISR operands of a host request, as decoded from the trace
+ * @details
+ * Only the AiM DMA reads these fields (while expanding an ISR into per-channel requests), so they are kept out of
+ * Request and shared between the copies of a host request instead of being copied through the controller queues.
+ * 
+ */
+struct AiMISRPayload {
     // [NOT_IMPLEMENTED] Increament order for ISR_WR_SBK, ISR_WR_HBK, and ISR_WR_ABK operations
     // struct IncreamentOrder {
     //     enum : int {
@@ -97,7 +134,14 @@ struct Request {
     // whose bit is set in channel mask.
     // NOT USED in ISR_EWADD.
     // Channel mask must show 1 channel in ISR_WR_ABK ISR
-    int64_t channel_mask = -1;
+    ChannelMask channel_mask;
+
+    // Channel of a conventional memory access
+    int32_t channel_id = -1;
+
+    // AiM device of the request; the channel mask (or channel) selects channels of this device. ISRs and memory
+    // accesses without it go to device 0, and SYNC and EOC without it to all devices
+    int16_t device_id = -1;
 
     // This request will be sent to a specific bank. USED only in single-bank ISRs, i.e.,
     // ISR_WR_SBK, ISR_RD_SBK, ISR_COPY_BKGB, ISR_COPY_GBBK, ISR_MAC_SBK, and ISR_EWMUL
@@ -111,24 +155,35 @@ struct Request {
 
     // Thread (register) index (0 or 1) for MAC and AF results
     int8_t thread_index = -1;
+};
 
-    // Broadcast only USED for ISR_MAC_SBK and ISR_MAC_ABK
-    // vector data for MAC is from GB (0) or next bank (1)
-    int16_t broadcast = -1;
+struct Request {
+    Addr_t addr = -1;
+    Data_t data;
+    AddrVec_t addr_vec{};
+    int host_req_id = -1;
+    int AiM_req_id = -1;
 
-    // AFM only USED for ISR_AF
-    // Activation Function mode selects AF (0-7)
-    int16_t afm = -1;
+    Type type = Type::MAX;
 
-    // ewmul bank group only USED for ISR_MAC_ABK
-    // EWMUL in one bank group (0) or all bank groups (1)
-    int16_t ewmul_bg = -1;
+    MemAccessRegion mem_access_region = MemAccessRegion::MAX;
+
+    Opcode opcode = Opcode::MAX;
+
+    // ISR operands of a host request. Per-channel requests do not carry it, their operands are in addr_vec
+    std::shared_ptr<const AiMISRPayload> payload;
 
     int source_id = -1; // An identifier for where the request is coming from (e.g., which core)
 
     int command = -1;       // The command that need to be issued to progress the request
     int final_command = -1; // The final command that is needed to finish the request
 
+    // Prerequisite command of preq_final_command cached by IDRAM::get_preq_command(Request&), valid while the state
+    // epoch of addr_vec is preq_epoch
+    int preq_command = -1;
+    int preq_final_command = -1;
+    int64_t preq_epoch = -1;
+
     Clk_t arrive = -1; // Clock cycle when the request arrive at the memory controller
     Clk_t issue = -1;  // Clock cycle when the request issued at the memory controller
     Clk_t depart = -1; // Clock cycle when the request depart the memory controller
@@ -142,9 +197,15 @@ struct Request {
     Request(Addr_t addr, int type_id, int source_id, std::function<void(Request &)> callback);
     // Request(Request const &req);
 
-    std::string str();
+    std::string str() const;
 
     bool is_reader();
+
+    /**
+     * @brief    Returns the ISR operands of a host request (an empty payload if it has none)
+     * 
+     */
+    const AiMISRPayload &isr() const;
 };
 
 class AiMISR {
@@ -195,7 +256,7 @@ public:
 
     std::string target_level;
 
-    bool is_field_legal(Field field) {
+    bool is_field_legal(Field field) const {
         if (std::count(legal_fields.begin(), legal_fields.end(), field))
             return true;
         return false;
@@ -438,14 +499,14 @@ public:
         if (type_valid(type_str) == false) {
             throw ConfigurationError("Trace: unknown type {}!", type_str.c_str());
         }
-        return str_to_type[type_str];
+        return str_to_type.at(type_str);
     }
 
     static std::string convert_type_to_str(Type type) {
         if (type_valid(type) == false) {
             throw ConfigurationError("Trace: unknown type {}!", (int)type);
         }
-        return type_to_str[type];
+        return type_to_str.at(type);
     }
 
     static bool AiM_opcode_valid(std::string AiM_opcode_str) {
@@ -472,18 +533,19 @@ public:
         if (AiM_opcode_valid(AiM_opcode_str) == false) {
             throw ConfigurationError("Trace: unknown AiM opcode {}!", AiM_opcode_str.c_str());
         }
-        return opcode_str_to_aim_ISR[AiM_opcode_str];
+        return opcode_str_to_aim_ISR.at(AiM_opcode_str);
     }
 
-    static AiMISR convert_AiM_opcode_to_AiM_ISR(Opcode AiM_opcode) {
-        return opcode_str_to_aim_ISR[convert_AiM_opcode_to_str(AiM_opcode)];
+    // Lookups after init() never modify the tables, so they are safe to call from the controller threads
+    static const AiMISR &convert_AiM_opcode_to_AiM_ISR(Opcode AiM_opcode) {
+        return opcode_str_to_aim_ISR.at(convert_AiM_opcode_to_str(AiM_opcode));
     }
 
     static std::string convert_AiM_opcode_to_str(Opcode AiM_opcode) {
         if (AiM_opcode_valid(AiM_opcode) == false) {
             throw ConfigurationError("Trace: unknown AiM opcode {}!", (int)AiM_opcode);
         }
-        return aim_opcode_to_str[AiM_opcode];
+        return aim_opcode_to_str.at(AiM_opcode);
     }
 
     static bool mem_access_region_valid(std::string mem_access_region_str) {
@@ -510,14 +572,14 @@ public:
         if (mem_access_region_valid(mem_access_region_str) == false) {
             throw ConfigurationError("Trace: unknown mem_access_region {}!", mem_access_region_str.c_str());
         }
-        return str_to_mem_access_region[mem_access_region_str];
+        return str_to_mem_access_region.at(mem_access_region_str);
     }
 
     static std::string convert_mem_access_region_to_str(MemAccessRegion mem_access_region) {
         if (mem_access_region_valid(mem_access_region) == false) {
             throw ConfigurationError("Trace: unknown mem_access_region {}!", (int)mem_access_region);
         }
-        return mem_access_region_to_str[mem_access_region];
+        return mem_access_region_to_str.at(mem_access_region);
     }
 
     static bool opcode_requires_reg_RW_mod(Opcode AiM_opcode) {
@@ -527,39 +589,214 @@ public:
 
 static AiMISRInfo AiM_host_request_info();
 
+/**
+ * @brief    Slab of request slots shared by the request buffers of a controller
+ * @details
+ * Retired slots are kept on a free list, so a steady-state enqueue reuses the storage of a retired request
+ * instead of allocating a list node. Slots live in a deque, so growing
+ * the pool never moves a request that is being referenced (e.g., from inside its callback).
+ * 
+ */
+struct ReqPool {
+    struct Slot {
+        Request req{(Addr_t)-1, -1};
+        int prev = -1;
+        int next = -1; // Next slot in the owning buffer, or in the free list
+    };
+
+    std::deque<Slot> slots;
+    int free_head = -1;
+
+    int allocate() {
+        if (free_head == -1) {
+            slots.emplace_back();
+            return slots.size() - 1;
+        }
+        int idx = free_head;
+        free_head = slots[idx].next;
+        return idx;
+    }
+
+    void release(int idx) {
+        slots[idx].next = free_head;
+        free_head = idx;
+    }
+};
+
+/**
+ * @brief    FIFO-ordered request buffer backed by a ReqPool
+ * @details
+ * Buffers constructed on the same pool move requests between each other by relinking the slot (move_to), so a
+ * request is copied once when it enters the controller. Iterators are stable handles: they stay valid until the
+ * request is removed from (or moved out of) its buffer.
+ * 
+ * A buffer with is_ordered_by_depart keeps its requests sorted by depart instead (FIFO among equal departs), e.g., to
+ * retire in-flight requests in completion order. Departures are mostly in issue order, so the insertion point is
+ * searched from the back.
+ * 
+ */
 struct ReqBuffer {
-    std::list<Request> buffer;
+    class iterator {
+        friend struct ReqBuffer;
+        ReqPool *m_pool = nullptr;
+        int m_idx = -1;
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Request;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Request *;
+        using reference = Request &;
+
+        iterator() = default;
+        iterator(ReqPool *pool, int idx) : m_pool(pool), m_idx(idx){};
+
+        Request &operator*() const { return m_pool->slots[m_idx].req; };
+        Request *operator->() const { return &m_pool->slots[m_idx].req; };
+        iterator &operator++() {
+            m_idx = m_pool->slots[m_idx].next;
+            return *this;
+        };
+        iterator operator++(int) {
+            iterator it = *this;
+            ++(*this);
+            return it;
+        };
+        iterator &operator--() {
+            m_idx = m_pool->slots[m_idx].prev;
+            return *this;
+        };
+        iterator operator--(int) {
+            iterator it = *this;
+            --(*this);
+            return it;
+        };
+        bool operator==(const iterator &other) const { return m_idx == other.m_idx; };
+        bool operator!=(const iterator &other) const { return m_idx != other.m_idx; };
+    };
+
     size_t max_size = 32;
+    bool is_ordered_by_depart = false;
+
+    ReqBuffer() : m_owned_pool(std::make_unique<ReqPool>()), m_pool(m_owned_pool.get()){};
+    explicit ReqBuffer(ReqPool &pool) : m_pool(&pool){};
+    ReqBuffer(const ReqBuffer &) = delete;
+    ReqBuffer &operator=(const ReqBuffer &) = delete;
+
+    iterator begin() { return iterator(m_pool, m_head); };
+    iterator end() { return iterator(m_pool, -1); };
 
-    using iterator = std::list<Request>::iterator;
-    iterator begin() { return buffer.begin(); };
-    iterator end() { return buffer.end(); };
+    size_t size() const { return m_size; }
 
-    size_t size() const { return buffer.size(); }
+    Request &back() { return m_pool->slots[m_tail].req; };
 
     bool enqueue(const Request &request) {
-        if (buffer.size() <= max_size) {
-            buffer.push_back(request);
+        if (m_size <= max_size) {
+            int idx = m_pool->allocate();
+            m_pool->slots[idx].req = request;
+            link(idx);
             return true;
         } else {
             return false;
         }
     }
 
-    void remove(iterator it) {
-        buffer.erase(it);
+    iterator remove(iterator it) {
+        int next = m_pool->slots[it.m_idx].next;
+        unlink(it.m_idx);
+        m_pool->release(it.m_idx);
+        return iterator(m_pool, next);
+    }
+
+    /**
+     * @brief    Moves the request to the back of another buffer, in place if both share a pool
+     * 
+     */
+    bool move_to(iterator it, ReqBuffer &other) {
+        if (other.m_pool != m_pool) {
+            if (!other.enqueue(*it)) {
+                return false;
+            }
+            remove(it);
+            return true;
+        }
+        if (other.m_size > other.max_size) {
+            return false;
+        }
+        unlink(it.m_idx);
+        other.link(it.m_idx);
+        return true;
+    }
+
+private:
+    std::unique_ptr<ReqPool> m_owned_pool; // Only set if the buffer does not share a pool
+    ReqPool *m_pool = nullptr;
+    int m_head = -1;
+    int m_tail = -1;
+    size_t m_size = 0;
+
+    void link(int idx) {
+        int prev = m_tail;
+        if (is_ordered_by_depart) {
+            Clk_t depart = m_pool->slots[idx].req.depart;
+            while ((prev != -1) && (m_pool->slots[prev].req.depart > depart)) {
+                prev = m_pool->slots[prev].prev;
+            }
+        }
+        link_after(prev, idx);
+    }
+
+    /**
+     * @brief    Links the slot after prev, or at the front if prev is -1
+     * 
+     */
+    void link_after(int prev, int idx) {
+        auto &slot = m_pool->slots[idx];
+        slot.prev = prev;
+        slot.next = (prev == -1) ? m_head : m_pool->slots[prev].next;
+        if (prev == -1) {
+            m_head = idx;
+        } else {
+            m_pool->slots[prev].next = idx;
+        }
+        if (slot.next == -1) {
+            m_tail = idx;
+        } else {
+            m_pool->slots[slot.next].prev = idx;
+        }
+        m_size++;
+    }
+
+    void unlink(int idx) {
+        auto &slot = m_pool->slots[idx];
+        if (slot.prev == -1) {
+            m_head = slot.next;
+        } else {
+            m_pool->slots[slot.prev].next = slot.next;
+        }
+        if (slot.next == -1) {
+            m_tail = slot.prev;
+        } else {
+            m_pool->slots[slot.next].prev = slot.prev;
+        }
+        m_size--;
     }
 };
 
+template <typename T>
+inline bool is_field_value_unset(const T &value) { return value == (T)-1; }
+
+inline bool is_field_value_unset(const ChannelMask &value) { return !value.is_set(); }
+
 template <typename T>
 void AiMISR::is_field_value_legal(AiMISR::Field field, T value) {
     if (is_field_legal(field)) {
-        if (value == (T)-1) {
+        if (is_field_value_unset(value)) {
             printf("Trace: opcode %s must be provided with field %s!", AiMISRInfo::convert_AiM_opcode_to_str(opcode).c_str(), field_to_str[field].c_str());
             exit(-1);
         }
     } else {
-        if (value != (T)-1) {
+        if (!is_field_value_unset(value)) {
             printf("Trace: opcode %s does not accept field %s!", AiMISRInfo::convert_AiM_opcode_to_str(opcode).c_str(), field_to_str[field].c_str());
             exit(-1);
         }
@@ -568,4 +805,4 @@ void AiMISR::is_field_value_legal(AiMISR::Field field, T value) {
 
 } // namespace Ramulator
 
-#endif // RAMULATOR_BASE_REQUEST_H
\ No newline at end of file
+#endif // RAMULATOR_BASE_REQUEST_H
\ No newline at end of file
@@ -1,6 +1,10 @@
 #ifndef RAMULATOR_BASE_TYPE_H
 #define RAMULATOR_BASE_TYPE_H
 
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
@@ -8,10 +12,76 @@
 
 namespace Ramulator {
 
-using Clk_t = int64_t;              // Clock cycle
-using Addr_t = int64_t;             // Plain address as seen by the OS
-using Data_t = int32_t;             // 1 byte data type
-using AddrVec_t = std::vector<int>; // Device address vector as is sent to the device from the controller
+/**
+ * @brief    Vector with a fixed capacity that keeps its elements inline
+ * @details
+ * Copying or resizing an InlineVec never touches the heap, which keeps small per-request
+ * containers (e.g., the device address vector) cheap to copy through the request queues.
+ * 
+ */
+template <typename T, size_t N>
+class InlineVec {
+private:
+    T m_data[N]{};
+    size_t m_size = 0;
+
+public:
+    InlineVec() = default;
+    InlineVec(size_t size, const T &value) { resize(size, value); };
+    InlineVec(std::initializer_list<T> values) {
+        for (const auto &value : values) {
+            push_back(value);
+        }
+    };
+    InlineVec(const std::vector<T> &values) {
+        for (const auto &value : values) {
+            push_back(value);
+        }
+    };
+
+    size_t size() const { return m_size; };
+    bool empty() const { return m_size == 0; };
+    static constexpr size_t capacity() { return N; };
+
+    T &operator[](size_t idx) { return m_data[idx]; };
+    const T &operator[](size_t idx) const { return m_data[idx]; };
+
+    T *data() { return m_data; };
+    const T *data() const { return m_data; };
+    T *begin() { return m_data; };
+    T *end() { return m_data + m_size; };
+    const T *begin() const { return m_data; };
+    const T *end() const { return m_data + m_size; };
+
+    void push_back(const T &value) {
+        if (m_size == N) {
+            throw std::length_error("InlineVec: capacity exceeded!");
+        }
+        m_data[m_size++] = value;
+    };
+
+    void resize(size_t size, const T &value = T()) {
+        if (size > N) {
+            throw std::length_error("InlineVec: capacity exceeded!");
+        }
+        for (size_t i = m_size; i < size; i++) {
+            m_data[i] = value;
+        }
+        m_size = size;
+    };
+
+    void clear() { m_size = 0; };
+
+    bool operator==(const InlineVec &other) const { return std::equal(begin(), end(), other.begin(), other.end()); };
+    bool operator!=(const InlineVec &other) const { return !(*this == other); };
+};
+
+inline constexpr size_t MAX_ADDR_LEVELS = 8; // Deepest organization hierarchy (channel ... column) of the supported DRAMs
+
+using Clk_t = int64_t;                             // Clock cycle
+using Addr_t = int64_t;                            // Plain address as seen by the OS
+using Data_t = int32_t;                            // 1 byte data type
+using AddrVec_t = InlineVec<int, MAX_ADDR_LEVELS>; // Device address vector as is sent to the device from the controller
 
 template <typename T>
 using Registry_t = std::unordered_map<std::string, T>;
@@ -28,4 +98,4 @@ inline constexpr bool is_specialization_of_v = is_specialization_of<T, Primary>:
 
 } // namespace Ramulator
 
-#endif // RAMULATOR_BASE_TYPE_H
\ No newline at end of file
+#endif // RAMULATOR_BASE_TYPE_H
\ No newline at end of file
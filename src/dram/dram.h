@@ -52,7 +52,8 @@ public:
     SpecDef m_timings;                     // The names of the timing constraints
     SpecLUT<int> m_timing_vals{m_timings}; // The LUT of the values for each timing constraints
 
-    TimingCons m_timing_cons; // The actual timing constraints used by Ramulator's DRAM model
+    TimingCons m_timing_cons;                  // The actual timing constraints used by Ramulator's DRAM model
+    CompiledTimingCons m_compiled_timing_cons; // m_timing_cons compiled for the node timing updates
 
     Clk_t m_read_latency = -1; // Number of cycles needed between issuing RD command and receiving data.
     SpecLUT<int> m_command_latencies{m_commands};
@@ -90,6 +91,42 @@ public:
      */
     virtual bool check_ready(int command, const AddrVec_t &addr_vec) = 0;
 
+    /**
+     * @brief     Returns the earliest cycle at which the device can accept the given command.
+     * @details
+     * Given a command and its address, this function should return the cycle from which the timing constraints
+     * along the address allow the command, assuming no other command is issued in between (-1 if unconstrained).
+     * The default only knows whether the command is ready now. Devices whose prerequisites also change with time
+     * (e.g., the LPDDR5 CAS sync window) should keep it, since a later ready cycle could be for a different command.
+     * 
+     */
+    virtual Clk_t earliest_ready_clk(int command, const AddrVec_t &addr_vec) { return check_ready(command, addr_vec) ? m_clk : m_clk + 1; };
+
+    /**
+     * @brief     Returns an epoch of the device state that decides the prerequisite commands at the given address
+     * @details
+     * The epoch must change whenever get_preq_command could return something else for a command at the address, so
+     * that callers may reuse a prerequisite command while the epoch stays the same. The default returns -1 (unknown)
+     * and nothing is reused. Devices whose prerequisites also change with time (e.g., the LPDDR5 CAS sync window), or
+     * look at nodes outside the address (e.g., the same bank of every bankgroup), should keep it.
+     * 
+     */
+    virtual int64_t get_state_epoch(const AddrVec_t &addr_vec) { return -1; };
+
+    /**
+     * @brief     Returns the prerequisite command of the request, reusing the one it cached while the epoch holds
+     * 
+     */
+    int get_preq_command(Request &req) {
+        int64_t epoch = get_state_epoch(req.addr_vec);
+        if ((epoch == -1) || (epoch != req.preq_epoch) || (req.final_command != req.preq_final_command)) {
+            req.preq_command = get_preq_command(req.final_command, req.addr_vec);
+            req.preq_final_command = req.final_command;
+            req.preq_epoch = epoch;
+        }
+        return req.preq_command;
+    };
+
     /**
      * @brief     Checks whether the command will result in a rowbuffer hit
      * @details
@@ -109,6 +146,12 @@ public:
      */
     virtual void notify(std::string_view key, uint64_t value){};
 
+    /**
+     * @brief     Advances the device by num_cycles without ticking it
+     * 
+     */
+    virtual void skip_cycles(Clk_t num_cycles) { m_clk += num_cycles; };
+
     /************************************************
    *        Interface to Query Device Spec
    ***********************************************/
@@ -180,6 +180,11 @@ public:
         return m_channels[channel_id]->check_ready(command, addr_vec, m_clk);
     };
 
+    Clk_t earliest_ready_clk(int command, const AddrVec_t &addr_vec) override {
+        int channel_id = addr_vec[m_levels["channel"]];
+        return m_channels[channel_id]->get_ready_clk(command, addr_vec);
+    };
+
     bool check_rowbuffer_hit(int command, const AddrVec_t &addr_vec) override {
         int channel_id = addr_vec[m_levels["channel"]];
         return m_channels[channel_id]->check_rowbuffer_hit(command, addr_vec, m_clk);
@@ -54,9 +54,9 @@ public:
              11,   // nWTRL
              28,   // nFAW
              210,  // nRFC
-             105,  // nRFCpb
-             14,   // nRREFD
              3333, // nREFI
+             14,   // nRREFD
+             105,  // nRFCpb
              0,    // nCLREG
              1,    // nCLGB
              1,    // nCWLREG
@@ -92,9 +92,9 @@ public:
              11,   // nWTRL
              42,   // nFAW
              210,  // nRFC
-             105,  // nRFCpb
-             21,   // nRREFD
              3333, // nREFI
+             21,   // nRREFD
+             105,  // nRFCpb
              0,    // nCLREG
              1,    // nCLGB
              1,    // nCWLREG
@@ -130,9 +130,9 @@ public:
              11,   // nWTRL
              28,   // nFAW
              210,  // nRFC
-             105,  // nRFCpb
-             14,   // nRREFD
              3333, // nREFI
+             14,   // nRREFD
+             105,  // nRFCpb
              0,    // nCLREG
              1,    // nCLGB
              1,    // nCWLREG
@@ -168,9 +168,9 @@ public:
              11,   // nWTRL
              42,   // nFAW
              210,  // nRFC
-             105,  // nRFCpb
-             21,   // nRREFD
              3333, // nREFI
+             21,   // nRREFD
+             105,  // nRFCpb
              0,    // nCLREG
              1,    // nCLGB
              1,    // nCWLREG
@@ -206,9 +206,9 @@ public:
              11,   // nWTRL
              42,   // nFAW (not used)
              210,  // nRFC
-             105,  // nRFCpb
-             21,   // nRREFD
              3333, // nREFI
+             21,   // nRREFD
+             105,  // nRFCpb
              0,    // nCLREG
              1,    // nCLGB
              1,    // nCWLREG
@@ -330,7 +330,7 @@ public:
         "read",
         "write",
         "all-bank-refresh",
-        "PREsb"};
+        "per-bank-refresh"};
 
     inline static constexpr ImplDef m_aim_requests = {
         "MIN",
@@ -358,7 +358,7 @@ public:
                                     {"read", "RD"},                // Read single bank
                                     {"write", "WR"},               // Write single bank
                                     {"all-bank-refresh", "REFab"}, // Referesh all banks
-                                    {"PREsb", "PRE"},              // Referesh single bank
+                                    {"per-bank-refresh", "REFpb"}, // Referesh single bank
                                 });
 
     inline static const ImplLUT m_aim_request_translations = LUT(
@@ -445,8 +445,6 @@ public:
     };
     std::vector<Node *> m_channels;
 
-    FuncMatrix<ActionFunc_t<Node>> m_actions;
-    FuncMatrix<PreqFunc_t<Node>> m_preqs;
     FuncMatrix<RowhitFunc_t<Node>> m_rowhits;
     FuncMatrix<RowopenFunc_t<Node>> m_rowopens;
 
@@ -460,8 +458,6 @@ public:
         set_organization();
         set_timing_vals();
 
-        set_actions();
-        set_preqs();
         // set_rowhits();
         // set_rowopens();
 
@@ -516,11 +512,21 @@ public:
         return m_channels[channel_id]->get_preq_command(command, addr_vec, m_clk);
     };
 
+    int64_t get_state_epoch(const AddrVec_t &addr_vec) override {
+        int channel_id = addr_vec[m_levels["channel"]];
+        return m_channels[channel_id]->get_state_epoch(addr_vec);
+    };
+
     bool check_ready(int command, const AddrVec_t &addr_vec) override {
         int channel_id = addr_vec[m_levels["channel"]];
         return m_channels[channel_id]->check_ready(command, addr_vec, m_clk);
     };
 
+    Clk_t earliest_ready_clk(int command, const AddrVec_t &addr_vec) override {
+        int channel_id = addr_vec[m_levels["channel"]];
+        return m_channels[channel_id]->get_ready_clk(command, addr_vec);
+    };
+
     bool check_rowbuffer_hit(int command, const AddrVec_t &addr_vec) override {
         assert(false); // Not implemented
         int channel_id = addr_vec[m_levels["channel"]];
@@ -673,7 +679,9 @@ private:
             }
         }(m_organization.density);
 
-        m_timing_vals("nRFC") = JEDEC_rounding(tRFC_TABLE[0][density_id], tCK_ps);
+        if (density_id != -1) {
+            m_timing_vals("nRFC") = JEDEC_rounding(tRFC_TABLE[0][density_id], tCK_ps);
+        }
         m_timing_vals("nREFI") = JEDEC_rounding(tREFI_BASE, tCK_ps);
 
         // Overwrite timing parameters with any user-provided value
@@ -768,6 +776,8 @@ private:
         m_command_latencies("WRA16") = m_timing_vals("nCWL") + m_timing_vals("nBL") + m_timing_vals("nRP");
         m_command_latencies("SYNC") = 1;
         m_command_latencies("EOC") = 1;
+        m_command_latencies("REFab") = 1;
+        m_command_latencies("REFpb") = 1;
 
 // Populate the timing constraints
 #define V(timing) (m_timing_vals(timing))
@@ -898,6 +908,8 @@ private:
                                       {.level = "channel", .preceding = {"REFpb"}, .following = {"ACT16"}, .latency = V("nRFCpb")},
                                       // "A minimum time tRREFD is required between a  REFpb command and an ACTIVATE command to a different bank"
                                       {.level = "channel", .preceding = {"REFpb"}, .following = {"ACT", "ACT4", "ACT16"}, .latency = V("nRREFD")},
+                                      // "A minimum time tRREFD is required between two REFpb commands to different banks"
+                                      {.level = "channel", .preceding = {"REFpb"}, .following = {"REFpb"}, .latency = V("nRREFD")},
 
                                       {.level = "channel", .preceding = {"PREA"}, .following = {"PRE", "PRE4", "PREA"}, .latency = V("nRP")},
                                       {.level = "channel", .preceding = {"PRE", "PRE4"}, .following = {"PREA"}, .latency = V("nRP")},
@@ -1001,48 +1013,98 @@ private:
 #undef V
     };
 
-    void set_actions() {
-        m_actions.resize(m_levels.size(), std::vector<ActionFunc_t<Node>>(m_commands.size()));
-
+public:
+    /**
+     * @brief    Applies the action of the command at the level of the node, returns false if there is none
+     * @details
+     * Dispatched with a switch instead of an m_actions table (see DRAMNodeBase::has_static_actions()).
+     * 
+     */
+    static bool apply_action(Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk) {
+        switch (node->m_level) {
         // Channel Actions
-        m_actions[m_levels["channel"]][m_commands["WRA16"]] = Lambdas::Action::Channel::PREab<GDDR6>;
-        m_actions[m_levels["channel"]][m_commands["PREA"]] = Lambdas::Action::Channel::PREab<GDDR6>;
-        m_actions[m_levels["channel"]][m_commands["ACT16"]] = Lambdas::Action::Channel::ACTab<GDDR6>;
+        case m_levels["channel"]:
+            switch (cmd) {
+            case m_commands["WRA16"]:
+            case m_commands["PREA"]:
+                Lambdas::Action::Channel::PREab<GDDR6>(node, cmd, addr_vec, clk);
+                return true;
+            case m_commands["ACT16"]:
+                Lambdas::Action::Channel::ACTab<GDDR6>(node, cmd, addr_vec, clk);
+                return true;
+            }
+            break;
 
         // Bank Group Actions
-        m_actions[m_levels["bankgroup"]][m_commands["PRE4"]] = Lambdas::Action::BankGroup::PRE4b<GDDR6>;
-        m_actions[m_levels["bankgroup"]][m_commands["ACT4"]] = Lambdas::Action::BankGroup::ACT4b<GDDR6>;
+        case m_levels["bankgroup"]:
+            switch (cmd) {
+            case m_commands["PRE4"]:
+                Lambdas::Action::BankGroup::PRE4b<GDDR6>(node, cmd, addr_vec, clk);
+                return true;
+            case m_commands["ACT4"]:
+                Lambdas::Action::BankGroup::ACT4b<GDDR6>(node, cmd, addr_vec, clk);
+                return true;
+            }
+            break;
 
         // Bank Actions
-        m_actions[m_levels["bank"]][m_commands["ACT"]] = Lambdas::Action::Bank::ACT<GDDR6>;
-        m_actions[m_levels["bank"]][m_commands["PRE"]] = Lambdas::Action::Bank::PRE<GDDR6>;
-        m_actions[m_levels["bank"]][m_commands["RDA"]] = Lambdas::Action::Bank::PRE<GDDR6>;
-        m_actions[m_levels["bank"]][m_commands["WRA"]] = Lambdas::Action::Bank::PRE<GDDR6>;
+        case m_levels["bank"]:
+            switch (cmd) {
+            case m_commands["ACT"]:
+                Lambdas::Action::Bank::ACT<GDDR6>(node, cmd, addr_vec, clk);
+                return true;
+            case m_commands["PRE"]:
+            case m_commands["RDA"]:
+            case m_commands["WRA"]:
+                Lambdas::Action::Bank::PRE<GDDR6>(node, cmd, addr_vec, clk);
+                return true;
+            }
+            break;
+        }
+        return false;
     };
 
-    void set_preqs() {
-        m_preqs.resize(m_levels.size(), std::vector<PreqFunc_t<Node>>(m_commands.size()));
-
+    /**
+     * @brief    Returns the prerequisite of the command at the level of the node, or -1 if there is none
+     * @details
+     * Dispatched with a switch instead of an m_preqs table (see DRAMNodeBase::has_static_preqs()).
+     * 
+     */
+    static int get_preq(Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk) {
+        switch (node->m_level) {
         // Channel Actions
-        m_preqs[m_levels["channel"]][m_commands["REFab"]] = Lambdas::Preq::Channel::RequireAllBanksClosed<GDDR6>;
+        case m_levels["channel"]:
+            switch (cmd) {
+            case m_commands["REFab"]:
+                return Lambdas::Preq::Channel::RequireAllBanksClosed<GDDR6>(node, cmd, addr_vec, clk);
+            case m_commands["WRA16"]:
+            case m_commands["MAC16"]:
+            case m_commands["AF16"]:
+            case m_commands["EWMUL16"]:
+                return Lambdas::Preq::Channel::RequireAllRowsOpen<GDDR6>(node, cmd, addr_vec, clk);
+            }
+            break;
 
         // Bank actions
-        m_preqs[m_levels["bank"]][m_commands["RD"]] = Lambdas::Preq::Bank::RequireRowOpen<GDDR6>;
-        m_preqs[m_levels["bank"]][m_commands["WR"]] = Lambdas::Preq::Bank::RequireRowOpen<GDDR6>;
-        m_preqs[m_levels["bank"]][m_commands["RDA"]] = Lambdas::Preq::Bank::RequireRowOpen<GDDR6>;
-        m_preqs[m_levels["bank"]][m_commands["WRA"]] = Lambdas::Preq::Bank::RequireRowOpen<GDDR6>;
-        //m_preqs[m_levels["channel"]][m_commands["REFpb"]] = Lambdas::Preq::Bank::RequireAllBanksClosed<GDDR6>; // can RequireSameBanksClosed be used, or is RequireBankClosed needed?
-
-        m_preqs[m_levels["bank"]][m_commands["RDCP"]] = Lambdas::Preq::Bank::RequireRowOpen<GDDR6>;
-        m_preqs[m_levels["bank"]][m_commands["WRCP"]] = Lambdas::Preq::Bank::RequireRowOpen<GDDR6>;
-        m_preqs[m_levels["bank"]][m_commands["MAC"]] = Lambdas::Preq::Bank::RequireRowOpen<GDDR6>;
-
-        m_preqs[m_levels["channel"]][m_commands["WRA16"]] = Lambdas::Preq::Channel::RequireAllRowsOpen<GDDR6>;
-        m_preqs[m_levels["channel"]][m_commands["MAC16"]] = Lambdas::Preq::Channel::RequireAllRowsOpen<GDDR6>;
-        m_preqs[m_levels["channel"]][m_commands["AF16"]] = Lambdas::Preq::Channel::RequireAllRowsOpen<GDDR6>;
-        m_preqs[m_levels["channel"]][m_commands["EWMUL16"]] = Lambdas::Preq::Channel::RequireAllRowsOpen<GDDR6>;
+        case m_levels["bank"]:
+            switch (cmd) {
+            case m_commands["RD"]:
+            case m_commands["WR"]:
+            case m_commands["RDA"]:
+            case m_commands["WRA"]:
+            case m_commands["RDCP"]:
+            case m_commands["WRCP"]:
+            case m_commands["MAC"]:
+                return Lambdas::Preq::Bank::RequireRowOpen<GDDR6>(node, cmd, addr_vec, clk);
+            case m_commands["REFpb"]:
+                return Lambdas::Preq::Bank::RequireBankClosed<GDDR6>(node, cmd, addr_vec, clk);
+            }
+            break;
+        }
+        return -1;
     };
 
+private:
     // Not implemented
     // void set_rowhits() {
     //     m_rowhits.resize(m_levels.size(), std::vector<RowhitFunc_t<Node>>(m_commands.size()));
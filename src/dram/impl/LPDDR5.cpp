@@ -805,7 +805,7 @@ private:
             for (auto bg : node->m_child_nodes) {
                 for (auto bank : bg->m_child_nodes) {
                     bank->m_state = m_states["Pre-Opened"];
-                    bank->m_row_state[target_id] = m_states["Pre-Opened"];
+                    bank->open_row(target_id);
                 }
             }
         };
@@ -820,15 +820,15 @@ private:
 
 #define ACTION_DEF(OP)                                                                \
     m_actions[m_levels["rank"]]                                                       \
-             [m_commands["CAS" #OP]] = [this](Node *node, int cmd,                    \
-                                              const AddrVec_t &addr_vec, Clk_t clk) { \
-                 node->m_final_synced_cycle = clk + m_command_latencies(#OP) + 1;     \
-             };                                                                       \
-                                                                                      \
-    m_actions[m_levels["rank"]]                                                       \
-             [m_commands[#OP]] = [this](Node *node, int cmd,                          \
-                                        const AddrVec_t &addr_vec, Clk_t clk) {       \
-                 node->m_final_synced_cycle = clk + m_command_latencies(#OP);         \
+             [m_commands["CAS" #OP]] = [](Node *node, int cmd,                                  \
+                                          const AddrVec_t &addr_vec, Clk_t clk) {               \
+                 node->m_final_synced_cycle = clk + node->m_spec->m_command_latencies(#OP) + 1; \
+             };                                                                                 \
+                                                                                                \
+    m_actions[m_levels["rank"]]                                                                 \
+             [m_commands[#OP]] = [](Node *node, int cmd,                                        \
+                                    const AddrVec_t &addr_vec, Clk_t clk) {                     \
+                 node->m_final_synced_cycle = clk + node->m_spec->m_command_latencies(#OP);     \
              }
 
         ACTION_DEF(RD);
@@ -844,7 +844,7 @@ private:
             int target_id = addr_vec[node->m_level + 2];
             for (auto bank : node->m_child_nodes) {
                 bank->m_state = m_states["Pre-Opened"];
-                bank->m_row_state[target_id] = m_states["Pre-Opened"];
+                bank->open_row(target_id);
             }
         };
         m_actions[m_levels["bankgroup"]][m_commands["ACT4-2"]] = Lambdas::Action::BankGroup::ACT4b<LPDDR5>;
@@ -854,7 +854,7 @@ private:
         m_actions[m_levels["bank"]][m_commands["ACT-1"]] = [](Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk) {
             int target_id = addr_vec[node->m_level + 1];
             node->m_state = m_states["Pre-Opened"];
-            node->m_row_state[target_id] = m_states["Pre-Opened"];
+            node->open_row(target_id);
         };
         m_actions[m_levels["bank"]][m_commands["ACT-2"]] = Lambdas::Action::Bank::ACT<LPDDR5>;
         m_actions[m_levels["bank"]][m_commands["PRE"]] = Lambdas::Action::Bank::PRE<LPDDR5>;
@@ -870,14 +870,14 @@ private:
         m_preqs[m_levels["rank"]][m_commands["REFab"]] = Lambdas::Preq::Rank::RequireAllBanksClosed<LPDDR5>;
         m_preqs[m_levels["rank"]][m_commands["RFMab"]] = Lambdas::Preq::Rank::RequireAllBanksClosed<LPDDR5>;
 
-        m_preqs[m_levels["rank"]][m_commands["REFpb"]] = [this](Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk) {
+        m_preqs[m_levels["rank"]][m_commands["REFpb"]] = [](Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk) {
             int target_id = addr_vec[node->m_level + 1];
             int target_bank_id = target_id;
             int another_target_bank_id = target_id + 8;
 
             for (auto bg : node->m_child_nodes) {
                 for (auto bank : bg->m_child_nodes) {
-                    int num_banks_per_bg = m_organization.count[m_levels["bank"]];
+                    int num_banks_per_bg = node->m_spec->m_organization.count[m_levels["bank"]];
                     int flat_bankid = bank->m_node_id + bg->m_node_id * num_banks_per_bg;
                     if (flat_bankid == target_id || flat_bankid == another_target_bank_id) {
                         switch (node->m_state) {
@@ -906,8 +906,7 @@ private:
                case m_states["Pre-Opened"]:                                                  \
                    return m_commands["ACT-2"];                                               \
                case m_states["Opened"]: {                                                    \
-                   if (node->m_row_state.find(target_id) !=                                  \
-                       node->m_row_state.end()) {                                            \
+                   if (node->is_row_open(target_id)) {                                       \
                        Node *rank = node->m_parent_node->m_parent_node;                      \
                        if (rank->m_final_synced_cycle < clk) {                               \
                            return m_commands[#CASOP]; /* CAS‑prefixed form */                \
@@ -939,8 +938,7 @@ private:
                case m_states["Pre-Opened"]:                                                  \
                    return m_commands["ACT-2"];                                               \
                case m_states["Opened"]: {                                                    \
-                   if (node->m_row_state.find(target_id) !=                                  \
-                       node->m_row_state.end()) {                                            \
+                   if (node->is_row_open(target_id)) {                                       \
                        return cmd;                                                           \
                    } else {                                                                  \
                        return m_commands["PRE"];                                             \
@@ -975,8 +973,7 @@ private:
                            any_pre_opened = true;                                                    \
                            break;                                                                    \
                        case m_states["Opened"]:                                                      \
-                           if (bank->m_row_state.find(target_id) ==                                  \
-                               bank->m_row_state.end())                                              \
+                           if (!bank->is_row_open(target_id))                                        \
                                any_open_diff = true;                                                 \
                            break;                                                                    \
                        default:                                                                      \
@@ -18,15 +18,15 @@ template <class T>
 void ACT(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk) {
     int target_id = addr_vec[node->m_level + 1];
     assert(node->m_state == T::m_states["Closed"]);
-    assert(node->m_row_state.size() == 0);
+    assert(!node->has_open_row());
     node->m_state = T::m_states["Opened"];
-    node->m_row_state[target_id] = T::m_states["Opened"];
+    node->open_row(target_id);
 };
 
 template <class T>
 void PRE(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk) {
     node->m_state = T::m_states["Closed"];
-    node->m_row_state.clear();
+    node->close_rows();
 };
 } // namespace Bank
 
@@ -39,7 +39,7 @@ void PREsb(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk
         for (auto bank : bg->m_child_nodes) {
             if (bank->m_node_id == target_id) {
                 bank->m_state = T::m_states["Closed"];
-                bank->m_row_state.clear();
+                bank->close_rows();
             }
         }
     }
@@ -66,9 +66,9 @@ void ACT4b(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk
     int target_id = addr_vec[T::m_levels["row"]];
     for (auto bank : node->m_child_nodes) {
         // assert(bank->m_state == T::m_states["Closed"]);
-        // assert(bank->m_row_state.size() == 0);
+        // assert(!bank->has_open_row());
         bank->m_state = T::m_states["Opened"];
-        bank->m_row_state[target_id] = T::m_states["Opened"];
+        bank->open_row(target_id);
     }
 }
 template <class T>
@@ -76,7 +76,7 @@ void PRE4b(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk
     assert(node->m_level == T::m_levels["bankgroup"]);
     for (auto bank : node->m_child_nodes) {
         bank->m_state = T::m_states["Closed"];
-        bank->m_row_state.clear();
+        bank->close_rows();
     }
 }
 } // namespace BankGroup
@@ -87,13 +87,13 @@ void PREab(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk
     if constexpr (T::m_levels["bank"] - T::m_levels["rank"] == 1) {
         for (auto bank : node->m_child_nodes) {
             bank->m_state = T::m_states["Closed"];
-            bank->m_row_state.clear();
+            bank->close_rows();
         }
     } else if constexpr (T::m_levels["bank"] - T::m_levels["rank"] == 2) {
         for (auto bg : node->m_child_nodes) {
             for (auto bank : bg->m_child_nodes) {
                 bank->m_state = T::m_states["Closed"];
-                bank->m_row_state.clear();
+                bank->close_rows();
             }
         }
     } else {
@@ -110,7 +110,7 @@ void PREsb(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk
         for (auto bank : bg->m_child_nodes) {
             if (bank->m_node_id == target_id) {
                 bank->m_state = T::m_states["Closed"];
-                bank->m_row_state.clear();
+                bank->close_rows();
             }
         }
     }
@@ -127,9 +127,9 @@ void ACTab(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk
         for (auto bg : node->m_child_nodes) {
             for (auto bank : bg->m_child_nodes) {
                 // assert(bank->m_state == T::m_states["Closed"]);
-                // assert(bank->m_row_state.size() == 0);
+                // assert(!bank->has_open_row());
                 bank->m_state = T::m_states["Opened"];
-                bank->m_row_state[target_id] = T::m_states["Opened"];
+                bank->open_row(target_id);
             }
         }
     } else if constexpr (T::m_levels["bank"] - T::m_levels["channel"] == 3) {
@@ -137,9 +137,9 @@ void ACTab(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk
             for (auto bg : pc->m_child_nodes) {
                 for (auto bank : bg->m_child_nodes) {
                     // assert(bank->m_state == T::m_states["Closed"]);
-                    // assert(bank->m_row_state.size() == 0);
+                    // assert(!bank->has_open_row());
                     bank->m_state = T::m_states["Opened"];
-                    bank->m_row_state[target_id] = T::m_states["Opened"];
+                    bank->open_row(target_id);
                 }
             }
         }
@@ -155,7 +155,7 @@ void PREab(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk
         for (auto bg : node->m_child_nodes) {
             for (auto bank : bg->m_child_nodes) {
                 bank->m_state = T::m_states["Closed"];
-                bank->m_row_state.clear();
+                bank->close_rows();
             }
         }
     } else if constexpr (T::m_levels["bank"] - T::m_levels["channel"] == 3) {
@@ -163,7 +163,7 @@ void PREab(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk
             for (auto bg : pc->m_child_nodes) {
                 for (auto bank : bg->m_child_nodes) {
                     bank->m_state = T::m_states["Closed"];
-                    bank->m_row_state.clear();
+                    bank->close_rows();
                 }
             }
         }
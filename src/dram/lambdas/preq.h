@@ -17,7 +17,7 @@ int RequireRowOpen(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, C
     case T::m_states["Closed"]:
         return T::m_commands["ACT"];
     case T::m_states["Opened"]: {
-        if (node->m_row_state.find(target_id) != node->m_row_state.end()) {
+        if (node->is_row_open(target_id)) {
             return cmd;
         } else {
             return T::m_commands["PRE"];
@@ -103,7 +103,7 @@ int RequireAllRowsOpen(typename T::Node *node, int cmd, const AddrVec_t &addr_ve
                     any_closed = true;
                     // printf("ch[%d] bg[%d] ba[%d] is closed!\n", node->m_node_id, bg->m_node_id, bank->m_node_id);
                 } else {
-                    if (bank->m_row_state.find(target_id) == bank->m_row_state.end()) {
+                    if (!bank->is_row_open(target_id)) {
                         // printf("ch[%d] bg[%d] ba[%d] is opened with another row!\n", node->m_node_id, bg->m_node_id, bank->m_node_id);
                         return T::m_commands["PREA"];
                     }
@@ -117,7 +117,7 @@ int RequireAllRowsOpen(typename T::Node *node, int cmd, const AddrVec_t &addr_ve
                     if (bank->m_state == T::m_states["Closed"]) {
                         any_closed = true;
                     } else {
-                        if (bank->m_row_state.find(target_id) == bank->m_row_state.end())
+                        if (!bank->is_row_open(target_id))
                             return T::m_commands["PREA"];
                     }
                 }
@@ -13,7 +13,7 @@ bool RDWR(typename T::Node *node, int cmd, int target_id, Clk_t clk) {
     case T::m_states["Closed"]:
         return false;
     case T::m_states["Opened"]:
-        if (node->m_row_state.find(target_id) != node->m_row_state.end()) {
+        if (node->is_row_open(target_id)) {
             return true;
         } else {
             return false;
@@ -1,12 +1,13 @@
 #ifndef RAMULATOR_DRAM_NODE_H
 #define RAMULATOR_DRAM_NODE_H
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <concepts>
 #include <cstdio>
-#include <deque>
 #include <functional>
-#include <map>
+#include <limits>
 #include <vector>
 
 #include "base/type.h"
@@ -27,6 +28,47 @@ concept IsDRAMSpec = requires(T t) {
 //   typename T::Node;
 // };
 
+/**
+ * @brief     Timing state of all nodes in one channel, stored level by level
+ * @details
+ * The ready-clocks (and command histories) of all nodes at the same level are kept in one contiguous array
+ * with one row per node and one column per command, instead of a pair of vectors in every node.
+ * Sibling timing constraints are not written into every sibling eagerly: the parent keeps, per command, the
+ * latest ready cycle imposed on its children (see DRAMSiblingHorizon) and children consult it when checked.
+ * 
+ */
+struct DRAMSiblingHorizon {
+    Clk_t best = -1;   // The latest ready cycle imposed on the children
+    int best_src = -1; // The child that imposed it (it does not apply to that child), -1 if it applies to all
+    Clk_t second = -1; // The latest ready cycle imposed by any other source (applies to best_src)
+
+    void update(Clk_t future, int src) {
+        if (src == best_src) {
+            best = std::max(best, future);
+        } else if (future > best) {
+            second = best;
+            best = future;
+            best_src = src;
+        } else {
+            second = std::max(second, future);
+        }
+    };
+
+    Clk_t get(int child_id) const {
+        return (child_id == best_src) ? second : best;
+    };
+};
+
+struct DRAMNodeTimingTable {
+    int num_cmds = 0;
+    std::vector<std::vector<Clk_t>> ready_clks;    // [level][node * num_cmds + cmd]
+    std::vector<std::vector<int>> history_windows; // [level][cmd]: How many past issues of the command are kept at this level (a power of two)
+    std::vector<int> history_widths;               // [level]: The largest history window at this level
+    std::vector<std::vector<Clk_t>> histories;     // [level][(node * num_cmds + cmd) * width + i], circular buffer of past issues
+    std::vector<std::vector<int>> history_heads;   // [level][node * num_cmds + cmd]: Position of the most recent issue in its circular buffer
+    std::vector<std::vector<DRAMSiblingHorizon>> sibling_horizons; // [level][parent * num_cmds + cmd]: Sibling constraints on the nodes of this level
+};
+
 /**
  * @brief     CRTP-ish (?) base class of a DRAM Device Node
  * 
@@ -45,27 +87,39 @@ struct DRAMNodeBase {
 
     int m_state = -1; // The state of the node
 
-    std::vector<Clk_t> m_cmd_ready_clk;           // The next cycle that each command can be issued again at this level
-    std::vector<std::deque<Clk_t>> m_cmd_history; // Issue-history of each command at this level
+    int64_t m_state_epoch = 0;   // Number of actions at this node (each may change my state and my descendants')
+    int64_t m_subtree_epoch = 0; // Number of actions at this node or any of my descendants
+
+    DRAMNodeTimingTable *m_timing_table = nullptr; // Timing state of the channel (owned by the channel node)
+    int m_index = -1;                              // The index of this node among all nodes at its level in the channel
+
+    Clk_t *m_cmd_ready_clk = nullptr; // The next cycle that each command can be issued again at this level (my row in m_timing_table)
+    Clk_t *m_cmd_history = nullptr;   // Issue-history of each command at this level (my row in m_timing_table)
+    int *m_cmd_history_head = nullptr; // Position of the most recent issue in each history (my row in m_timing_table)
+    DRAMSiblingHorizon *m_sibling_horizon = nullptr;       // Sibling constraints imposed on me and my siblings (my parent's row)
+    DRAMSiblingHorizon *m_child_sibling_horizon = nullptr; // Sibling constraints imposed on my children (my row)
 
     using RowId_t = int;
-    using RowState_t = int;
-    std::map<RowId_t, RowState_t> m_row_state; // The state of the rows, if I am a bank-ish node
+    RowId_t m_open_row = -1;            // The open row, if I am a bank-ish node (-1 if none)
+    std::vector<RowId_t> m_open_rows;   // All open rows, only used by specs that keep several rows of a bank open
 
     DRAMNodeBase(T *spec, NodeType *parent, int level, int id) : m_spec(spec), m_parent_node(parent), m_level(level), m_node_id(id) {
-        int num_cmds = T::m_commands.size();
-        m_cmd_ready_clk.resize(num_cmds, -1);
-        m_cmd_history.resize(num_cmds);
-        for (int cmd = 0; cmd < num_cmds; cmd++) {
-            int window = 0;
-            for (const auto &t : spec->m_timing_cons[level][cmd]) {
-                window = std::max(window, t.window);
-            }
-            if (window != 0) {
-                m_cmd_history[cmd].resize(window, -1);
-            } else {
-                m_cmd_history[cmd].clear();
-            }
+        if (parent == nullptr) {
+            m_timing_table = create_timing_table(spec);
+            m_index = 0;
+        } else {
+            m_timing_table = parent->m_timing_table;
+            m_index = parent->m_index * spec->m_organization.count[level] + id;
+        }
+        int num_cmds = m_timing_table->num_cmds;
+        m_cmd_ready_clk = m_timing_table->ready_clks[level].data() + m_index * num_cmds;
+        m_cmd_history = m_timing_table->histories[level].data() + m_index * num_cmds * m_timing_table->history_widths[level];
+        m_cmd_history_head = m_timing_table->history_heads[level].data() + m_index * num_cmds;
+        if (parent != nullptr) {
+            m_sibling_horizon = parent->m_child_sibling_horizon;
+        }
+        if (level + 1 < T::m_levels["row"]) {
+            m_child_sibling_horizon = m_timing_table->sibling_horizons[level + 1].data() + m_index * num_cmds;
         }
 
         m_state = spec->m_init_states[m_level];
@@ -88,10 +142,84 @@ struct DRAMNodeBase {
         }
     };
 
+    /**
+     * @brief     Row-buffer state of a bank-ish node
+     * @details
+     * A bank has at most one open row in most specs, so it is kept in a single register and a row-hit check is one compare.
+     * Specs that keep several rows of a bank open declare `static constexpr bool m_multi_row_open = true;`.
+     * 
+     */
+    static constexpr bool is_multi_row() {
+        if constexpr (requires { T::m_multi_row_open; }) {
+            return T::m_multi_row_open;
+        } else {
+            return false;
+        }
+    };
+
+    bool is_row_open(RowId_t row) const {
+        if constexpr (is_multi_row()) {
+            return std::find(m_open_rows.begin(), m_open_rows.end(), row) != m_open_rows.end();
+        } else {
+            return m_open_row == row;
+        }
+    };
+
+    bool has_open_row() const {
+        return m_open_row != -1;
+    };
+
+    void open_row(RowId_t row) {
+        if constexpr (is_multi_row()) {
+            if (!is_row_open(row)) {
+                m_open_rows.push_back(row);
+            }
+        }
+        m_open_row = row;
+    };
+
+    void close_rows() {
+        m_open_row = -1;
+        if constexpr (is_multi_row()) {
+            m_open_rows.clear();
+        }
+    };
+
+    /**
+     * @brief     Whether the spec dispatches its actions and prerequisites with a switch instead of m_actions / m_preqs
+     * @details
+     * Such a spec defines a public `static bool apply_action(Node *, int cmd, const AddrVec_t &, Clk_t)`, which applies the
+     * action of the command at the level of the node and returns whether there is one, and/or
+     * `static int get_preq(Node *, int cmd, const AddrVec_t &, Clk_t)`, which returns the prerequisite at the level of
+     * the node (-1 if none). They are resolved at compile time, so they can be inlined into the node.
+     * 
+     */
+    static constexpr bool has_static_actions() {
+        return requires(NodeType *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk) {
+            { T::apply_action(node, cmd, addr_vec, clk) } -> std::same_as<bool>;
+        };
+    };
+
+    static constexpr bool has_static_preqs() {
+        return requires(NodeType *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk) {
+            { T::get_preq(node, cmd, addr_vec, clk) } -> std::same_as<int>;
+        };
+    };
+
     void update_states(int command, const AddrVec_t &addr_vec, Clk_t clk) {
-        if (m_spec->m_actions[m_level][command]) {
-            // update the state machine at this level
+        // update the state machine at this level
+        bool has_action = false;
+        if constexpr (has_static_actions()) {
+            has_action = T::apply_action(static_cast<NodeType *>(this), command, addr_vec, clk);
+        } else if (m_spec->m_actions[m_level][command]) {
             m_spec->m_actions[m_level][command](static_cast<NodeType *>(this), command, addr_vec, clk);
+            has_action = true;
+        }
+        if (has_action) {
+            m_state_epoch++;
+            for (DRAMNodeBase *node = this; node != nullptr; node = node->m_parent_node) {
+                node->m_subtree_epoch++;
+            }
         }
         if (m_level == m_spec->m_command_scopes[command] || !m_child_nodes.size()) {
             // stop recursion: updated all levels
@@ -113,13 +241,9 @@ struct DRAMNodeBase {
         /************************************************
        *         Update Sibling Node Timing
        ***********************************************/
+        const CompiledTimingCons &timing_cons = m_spec->m_compiled_timing_cons;
         if (m_node_id != addr_vec[m_level]) {
-            for (const auto &t : m_spec->m_timing_cons[m_level][command]) {
-                if (t.sibling == false) {
-                    // not sibling timing parameter
-                    continue;
-                }
-
+            for (const auto &t : timing_cons.siblings[m_level][command]) {
                 // update earliest schedulable time of every command
                 Clk_t future = clk + t.val;
                 m_cmd_ready_clk[t.cmd] = std::max(m_cmd_ready_clk[t.cmd], future);
@@ -131,19 +255,28 @@ struct DRAMNodeBase {
         /************************************************
        *          Update Target Node Timing
        ***********************************************/
-        // Update history
-        if (m_cmd_history[command].size()) {
-            m_cmd_history[command].pop_back();
-            m_cmd_history[command].push_front(clk);
+        // Window-1 constraints only depend on this issue: one max over the whole row of commands
+        if (timing_cons.has_deltas[m_level][command]) {
+            int num_cmds = timing_cons.num_cmds;
+            const Clk_t *deltas = timing_cons.deltas[m_level].data() + command * num_cmds;
+            for (int cmd = 0; cmd < num_cmds; cmd++) {
+                m_cmd_ready_clk[cmd] = std::max(m_cmd_ready_clk[cmd], clk + deltas[cmd]);
+            }
         }
 
-        for (const auto &t : m_spec->m_timing_cons[m_level][command]) {
-            if (t.sibling == true) {
-                continue;
-            }
+        // Update history (only kept for windowed constraints)
+        int window = m_timing_table->history_windows[m_level][command];
+        Clk_t *history = m_cmd_history + command * m_timing_table->history_widths[m_level];
+        int &head = m_cmd_history_head[command];
+        if (window) {
+            // The newest issue overwrites the oldest one
+            head = (head - 1) & (window - 1);
+            history[head] = clk;
+        }
 
+        for (const auto &t : timing_cons.windowed[m_level][command]) {
             // Get the oldest history
-            Clk_t past = m_cmd_history[command][t.window - 1];
+            Clk_t past = history[(head + t.window - 1) & (window - 1)];
             if (past < 0) {
                 // not enough history
                 continue;
@@ -159,10 +292,20 @@ struct DRAMNodeBase {
             return;
         }
 
-        // recursively update all of my children
-        for (auto child : m_child_nodes) {
-            child->update_timing(command, addr_vec, clk);
+        // Record the sibling constraints once for all of my children instead of updating every child
+        int child_id = addr_vec[m_level + 1];
+        for (const auto &t : timing_cons.siblings[m_level + 1][command]) {
+            m_child_sibling_horizon[t.cmd].update(clk + t.val, child_id);
+        }
+
+        if (child_id < 0) {
+            // stop recursion: all of my children are siblings
+            return;
         }
+
+        // recursively update the target child
+        assert(child_id < m_child_nodes.size());
+        m_child_nodes[child_id]->update_timing(command, addr_vec, clk);
     };
 
     int get_preq_command(int command, const AddrVec_t &addr_vec, Clk_t m_clk) {
@@ -170,12 +313,15 @@ struct DRAMNodeBase {
         // printf("m_level: %d\n", m_level);
         // printf("size[%d]\n", m_spec->m_preqs.size());
         // printf("size[%d][%d]\n", m_spec->m_preqs.size(), m_spec->m_preqs[m_level].size());
-        if (m_spec->m_preqs[m_level][command]) {
-            int preq_cmd = m_spec->m_preqs[m_level][command](static_cast<NodeType *>(this), command, addr_vec, m_clk);
-            if (preq_cmd != -1) {
-                // stop recursion: there is a prerequisite at this level
-                return preq_cmd;
-            }
+        int preq_cmd = -1;
+        if constexpr (has_static_preqs()) {
+            preq_cmd = T::get_preq(static_cast<NodeType *>(this), command, addr_vec, m_clk);
+        } else if (m_spec->m_preqs[m_level][command]) {
+            preq_cmd = m_spec->m_preqs[m_level][command](static_cast<NodeType *>(this), command, addr_vec, m_clk);
+        }
+        if (preq_cmd != -1) {
+            // stop recursion: there is a prerequisite at this level
+            return preq_cmd;
         }
 
         if (!m_child_nodes.size()) {
@@ -201,8 +347,31 @@ struct DRAMNodeBase {
         return m_child_nodes[child_id]->get_preq_command(command, addr_vec, m_clk);
     };
 
+    /**
+     * @brief     Returns a counter that changes whenever an action may have changed a state that the address sees
+     * @details
+     * These are the states of the nodes along the address (changed by actions at them or at their ancestors) and
+     * the states below its deepest node (changed by actions at any of its descendants). The counters only grow, so
+     * their sum never repeats a value.
+     * 
+     */
+    int64_t get_state_epoch(const AddrVec_t &addr_vec) const {
+        int child_id = (m_child_nodes.size() != 0) ? addr_vec[m_level + 1] : -1;
+        if (child_id < 0) {
+            // stop recursion: the address covers my whole subtree
+            return m_subtree_epoch;
+        }
+
+        assert(child_id < m_child_nodes.size());
+        return m_state_epoch + m_child_nodes[child_id]->get_state_epoch(addr_vec);
+    };
+
     bool check_ready(int command, const AddrVec_t &addr_vec, Clk_t clk) {
-        if (m_cmd_ready_clk[command] != -1 && clk < m_cmd_ready_clk[command]) {
+        Clk_t ready_clk = m_cmd_ready_clk[command];
+        if (m_sibling_horizon) {
+            ready_clk = std::max(ready_clk, m_sibling_horizon[command].get(m_node_id));
+        }
+        if (ready_clk != -1 && clk < ready_clk) {
             // stop recursion: the check failed at this level
             return false;
         }
@@ -224,6 +393,65 @@ struct DRAMNodeBase {
         return m_child_nodes[child_id]->check_ready(command, addr_vec, clk);
     };
 
+    Clk_t get_ready_clk(int command, const AddrVec_t &addr_vec) {
+        // The latest ready cycle of the command along the path to its target
+        Clk_t ready_clk = m_cmd_ready_clk[command];
+        if (m_sibling_horizon) {
+            ready_clk = std::max(ready_clk, m_sibling_horizon[command].get(m_node_id));
+        }
+
+        if (m_level == m_spec->m_command_scopes[command] || !m_child_nodes.size()) {
+            // stop recursion: reached the scope of the command
+            return ready_clk;
+        }
+
+        int child_id = addr_vec[m_level + 1];
+        if (child_id < 0) {
+            // stop recursion: the command does not target a single child
+            return ready_clk;
+        }
+
+        assert(child_id < m_child_nodes.size());
+        return std::max(ready_clk, m_child_nodes[child_id]->get_ready_clk(command, addr_vec));
+    };
+
+    static DRAMNodeTimingTable *create_timing_table(T *spec) {
+        DRAMNodeTimingTable *table = new DRAMNodeTimingTable();
+        int num_cmds = T::m_commands.size();
+        int last_level = T::m_levels["row"];
+        table->num_cmds = num_cmds;
+        table->ready_clks.resize(last_level);
+        table->history_windows.resize(last_level, std::vector<int>(num_cmds, 0));
+        table->history_widths.resize(last_level, 0);
+        table->histories.resize(last_level);
+        table->history_heads.resize(last_level);
+        table->sibling_horizons.resize(last_level);
+
+        // One channel node, then count[level] children for every node of the previous level
+        int num_nodes = 1;
+        for (int level = 0; level < last_level; level++) {
+            if (level != 0) {
+                num_nodes *= std::max(spec->m_organization.count[level], 0);
+            }
+            for (int cmd = 0; cmd < num_cmds; cmd++) {
+                int window = 0;
+                for (const auto &t : spec->m_compiled_timing_cons.windowed[level][cmd]) {
+                    window = std::max(window, t.window);
+                }
+                // Rounded up to a power of two, so that the circular buffer wraps around with a mask instead of a branch
+                table->history_windows[level][cmd] = (window == 0) ? 0 : std::bit_ceil((unsigned)window);
+                table->history_widths[level] = std::max(table->history_widths[level], table->history_windows[level][cmd]);
+            }
+            table->ready_clks[level].resize(num_nodes * num_cmds, -1);
+            table->histories[level].resize(num_nodes * num_cmds * table->history_widths[level], -1);
+            table->history_heads[level].resize(num_nodes * num_cmds, 0);
+            if (level != 0) {
+                table->sibling_horizons[level].resize(num_nodes / std::max(spec->m_organization.count[level], 1) * num_cmds);
+            }
+        }
+        return table;
+    };
+
     bool check_rowbuffer_hit(int command, const AddrVec_t &addr_vec, Clk_t m_clk) {
         assert(false); // Not implemented
         int child_id = addr_vec[m_level + 1];
@@ -244,12 +472,14 @@ struct DRAMNodeBase {
     };
 };
 
+// Plain function pointers (not std::function) so that the per-command dispatch is a single direct indirect call.
+// Lambdas stored in these matrices must therefore be captureless; the spec is reachable through node->m_spec.
 template <class T>
-using ActionFunc_t = std::function<void(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk)>;
+using ActionFunc_t = void (*)(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk);
 template <class T>
-using PreqFunc_t = std::function<int(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk)>;
+using PreqFunc_t = int (*)(typename T::Node *node, int cmd, const AddrVec_t &addr_vec, Clk_t clk);
 template <class T>
-using RowhitFunc_t = std::function<bool(typename T::Node *node, int cmd, int target_id, Clk_t clk)>;
+using RowhitFunc_t = bool (*)(typename T::Node *node, int cmd, int target_id, Clk_t clk);
 template <class T>
 using RowopenFunc_t = RowhitFunc_t<T>;
 
@@ -1,9 +1,11 @@
 #ifndef RAMULATOR_DEVICE_SPEC_H
 #define RAMULATOR_DEVICE_SPEC_H
 
+#include <algorithm>
 #include <array>
 #include <cstdio>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <ostream>
 #include <ranges>
@@ -14,6 +16,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include "base/type.h"
+
 namespace Ramulator {
 
 using Level_t = int;
@@ -59,6 +63,64 @@ struct TimingConsEntry {
 
 using TimingCons = std::vector<std::vector<std::vector<TimingConsEntry>>>;
 
+/**
+ * @brief     Timing constraints compiled for fast updates of the node timing tables
+ * @details
+ * The constraints of each (level, preceding command) are split by how they are applied:
+ * the common non-sibling window-1 constraints form a dense row over all following commands (updated with a
+ * branch-free max over the row), while sibling and windowed (e.g., nFAW) constraints stay in short lists
+ * with duplicate entries merged.
+ * 
+ */
+struct CompiledTimingCons {
+    static constexpr Clk_t no_constraint = std::numeric_limits<Clk_t>::min() / 2;
+
+    int num_cmds = 0;
+    std::vector<std::vector<Clk_t>> deltas;                  // [level][p_cmd * num_cmds + f_cmd]: window-1 latency, no_constraint if none
+    std::vector<std::vector<uint8_t>> has_deltas;            // [level][p_cmd]: Whether any window-1 constraint exists
+    std::vector<std::vector<std::vector<TimingConsEntry>>> siblings; // [level][p_cmd]: Sibling constraints, one entry per f_cmd
+    std::vector<std::vector<std::vector<TimingConsEntry>>> windowed; // [level][p_cmd]: Non-sibling constraints with window > 1
+};
+
+inline CompiledTimingCons compile_timingcons(const TimingCons &timing_cons, int num_cmds) {
+    CompiledTimingCons compiled;
+    int num_levels = timing_cons.size();
+    compiled.num_cmds = num_cmds;
+    compiled.deltas.resize(num_levels, std::vector<Clk_t>(num_cmds * num_cmds, CompiledTimingCons::no_constraint));
+    compiled.has_deltas.resize(num_levels, std::vector<uint8_t>(num_cmds, 0));
+    compiled.siblings.resize(num_levels, std::vector<std::vector<TimingConsEntry>>(num_cmds));
+    compiled.windowed.resize(num_levels, std::vector<std::vector<TimingConsEntry>>(num_cmds));
+
+    for (int level = 0; level < num_levels; level++) {
+        for (int p_cmd = 0; p_cmd < num_cmds; p_cmd++) {
+            for (const auto &t : timing_cons[level][p_cmd]) {
+                if (t.sibling) {
+                    auto &siblings = compiled.siblings[level][p_cmd];
+                    auto it = std::find_if(siblings.begin(), siblings.end(), [&](const auto &s) { return s.cmd == t.cmd; });
+                    if (it == siblings.end()) {
+                        siblings.push_back(t);
+                    } else {
+                        it->val = std::max(it->val, t.val);
+                    }
+                } else if (t.window == 1) {
+                    Clk_t &delta = compiled.deltas[level][p_cmd * num_cmds + t.cmd];
+                    delta = std::max(delta, (Clk_t)t.val);
+                    compiled.has_deltas[level][p_cmd] = 1;
+                } else {
+                    auto &windowed = compiled.windowed[level][p_cmd];
+                    auto it = std::find_if(windowed.begin(), windowed.end(), [&](const auto &w) { return w.cmd == t.cmd && w.window == t.window; });
+                    if (it == windowed.end()) {
+                        windowed.push_back(t);
+                    } else {
+                        it->val = std::max(it->val, t.val);
+                    }
+                }
+            }
+        }
+    }
+    return compiled;
+};
+
 // // TODO: Write a expression parser and evaluator
 // template<class T>
 // int EvalTimingExpr(T* spec, std::string_view expr) {
@@ -89,6 +151,7 @@ void populate_timingcons(T *spec, std::vector<TimingConsInitializer> initializer
             }
         }
     }
+    spec->m_compiled_timing_cons = compile_timingcons(spec->m_timing_cons, T::m_commands.size());
 };
 
 template <int N>
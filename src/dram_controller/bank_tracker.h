@@ -0,0 +1,123 @@
+#ifndef RAMULATOR_CONTROLLER_BANK_TRACKER_H
+#define RAMULATOR_CONTROLLER_BANK_TRACKER_H
+
+#include <algorithm>
+#include <vector>
+
+#include "base/base.h"
+#include "dram/dram.h"
+
+namespace Ramulator {
+
+/**
+ * @brief    Numbers the banks of a channel, so that per-bank state can be kept in flat arrays
+ * @details
+ * A controller only buffers requests to its own channel, so the levels between the channel and the row (e.g., rank,
+ * bankgroup, and bank) make up the flat bank id.
+ * 
+ */
+class BankMap {
+private:
+    int m_channel_addr_idx = -1;
+    int m_row_addr_idx = -1;
+    std::vector<int> m_bank_strides; // [level]: Stride of each level below the channel in the flat bank id
+    int m_num_banks = 0;
+
+public:
+    void setup(IDRAM *dram) {
+        m_channel_addr_idx = dram->m_levels("channel");
+        m_row_addr_idx = dram->m_levels("row");
+        m_bank_strides.assign(m_row_addr_idx, 0);
+        m_num_banks = 1;
+        for (int level = m_row_addr_idx - 1; level > m_channel_addr_idx; level--) {
+            m_bank_strides[level] = m_num_banks;
+            m_num_banks *= std::max(dram->m_organization.count[level], 1);
+        }
+    };
+
+    int get_num_banks() const { return m_num_banks; };
+
+    int get_row_addr_idx() const { return m_row_addr_idx; };
+
+    /**
+     * @brief    Returns the bank of the address within its channel, or -1 if it targets more than one bank
+     * 
+     */
+    int get_flat_bank_id(const AddrVec_t &addr_vec) const {
+        int bank_id = 0;
+        for (int level = m_channel_addr_idx + 1; level < m_row_addr_idx; level++) {
+            if (addr_vec[level] < 0) {
+                return -1;
+            }
+            bank_id += addr_vec[level] * m_bank_strides[level];
+        }
+        return bank_id;
+    };
+};
+
+/**
+ * @brief    Counts the requests in the active buffer of a controller per bank
+ * @details
+ * A request enters the active buffer once it has opened its row, so a closing command would interrupt it if the
+ * bank has a non-zero count. The controller updates the counts whenever a request enters or leaves the buffer,
+ * which makes the check a lookup instead of a scan of the buffer.
+ * 
+ */
+class ActiveBankTracker {
+private:
+    BankMap m_bank_map;
+    std::vector<int> m_num_active_reqs; // [flat bank id]
+    int m_num_multi_bank_reqs = 0;      // Active requests that do not target a single bank
+    int m_num_reqs = 0;
+
+public:
+    void setup(IDRAM *dram) {
+        m_bank_map.setup(dram);
+        m_num_active_reqs.assign(m_bank_map.get_num_banks(), 0);
+    };
+
+    void add(const Request &req) {
+        m_num_reqs++;
+        int bank_id = m_bank_map.get_flat_bank_id(req.addr_vec);
+        if (bank_id < 0) {
+            m_num_multi_bank_reqs++;
+        } else {
+            m_num_active_reqs[bank_id]++;
+        }
+    };
+
+    void remove(const Request &req) {
+        m_num_reqs--;
+        int bank_id = m_bank_map.get_flat_bank_id(req.addr_vec);
+        if (bank_id < 0) {
+            m_num_multi_bank_reqs--;
+        } else {
+            m_num_active_reqs[bank_id]--;
+        }
+    };
+
+    /**
+     * @brief    Returns whether an active request targets exactly the bank of the address (-1 matches no bank)
+     * 
+     */
+    bool is_bank_active(const AddrVec_t &addr_vec) const {
+        int bank_id = m_bank_map.get_flat_bank_id(addr_vec);
+        return (bank_id >= 0) && (m_num_active_reqs[bank_id] != 0);
+    };
+
+    /**
+     * @brief    Returns whether an active request overlaps with the banks of the address (-1 matches any bank)
+     * 
+     */
+    bool is_any_bank_active(const AddrVec_t &addr_vec) const {
+        int bank_id = m_bank_map.get_flat_bank_id(addr_vec);
+        if (bank_id < 0) {
+            return m_num_reqs != 0;
+        }
+        return (m_num_active_reqs[bank_id] != 0) || (m_num_multi_bank_reqs != 0);
+    };
+};
+
+} // namespace Ramulator
+
+#endif // RAMULATOR_CONTROLLER_BANK_TRACKER_H
@@ -42,12 +42,45 @@ public:
      */
     virtual bool priority_send(Request &req) = 0;
 
+    /**
+     * @brief       Returns how many high-priority requests (e.g., refreshes) are buffered and not served yet.
+     * 
+     */
+    virtual size_t get_num_priority_requests() { return 0; };
+
+    /**
+     * @brief       Returns whether the controller has no buffered request to serve (in-flight requests aside).
+     * 
+     */
+    virtual bool is_idle() { return false; };
+
+    /**
+     * @brief       Returns whether every buffered request ahead of the next synchronization point has been served.
+     * @details
+     * The synchronization points are e.g. AiM SYNC and EOC requests. Maintenance started at such a point does not
+     * interrupt a sequence of dependent operations.
+     * 
+     */
+    virtual bool is_at_sync_boundary() { return is_idle(); };
+
     /**
      * @brief       Ticks the memory controller.
      * 
      */
     virtual void tick() = 0;
 
+    /**
+     * @brief       Returns how many upcoming ticks are guaranteed to not change the controller state.
+     * 
+     */
+    virtual Clk_t get_skippable_cycles() { return 0; };
+
+    /**
+     * @brief       Advances the memory controller by num_cycles without ticking it.
+     * 
+     */
+    virtual void skip_cycles(Clk_t num_cycles) { m_clk += num_cycles; };
+
     uint get_clock_ratio() { return m_clock_ratio; };
 };
 
@@ -1,7 +1,10 @@
 #include "base/request.h"
+#include "dram_controller/bank_tracker.h"
 #include "dram_controller/controller.h"
+#include "dram_controller/write_index.h"
 #include "memory_system/memory_system.h"
 #include <cstdio>
+#include <limits>
 #include <string>
 
 namespace Ramulator {
@@ -10,14 +13,36 @@ class AiMDRAMController final : public IDRAMController, public Implementation {
     RAMULATOR_REGISTER_IMPLEMENTATION(IDRAMController, AiMDRAMController, "AiM", "AiM DRAM controller.");
 
 private:
-    std::deque<Request> pending_reads;   // A queue for read requests that are about to finish (callback after RL)
-    std::vector<Request> pending_writes; // A queue for write requests that are about to finish
+    /**
+     * @brief    How AiM and read/write requests share the channel
+     * @details
+     * Exclusive alternates between AiM and read/write phases. The other policies let both classes be buffered at
+     * the same time as long as they do not touch the same row of a bank, and only differ in which class is served
+     * when both have a ready request.
+     * 
+     */
+    enum class Arbitration {
+        Exclusive,
+        AiMFirst,
+        HostFirst,
+        Weighted
+    };
 
-    ReqBuffer m_active_buffer;   // Buffer for requests being served. This has the highest priority
-    ReqBuffer m_priority_buffer; // Buffer for high-priority requests (e.g., maintenance like refresh).
-    ReqBuffer m_read_buffer;     // Read request buffer
-    ReqBuffer m_write_buffer;    // Write request buffer
-    ReqBuffer m_aim_buffer;      // AiM request buffer
+    ReqPool m_req_pool; // Storage of all requests in the controller, so that they move between buffers in place
+
+    ReqBuffer pending_reads{m_req_pool};  // Read requests that are about to finish (callback after RL), by depart
+    ReqBuffer pending_writes{m_req_pool}; // Write requests that are about to finish, by depart
+
+    ReqBuffer m_active_buffer{m_req_pool};   // Buffer for requests being served. This has the highest priority
+    ReqBuffer m_priority_buffer{m_req_pool}; // Buffer for high-priority requests (e.g., maintenance like refresh).
+    ReqBuffer m_read_buffer{m_req_pool};     // Read request buffer
+    ReqBuffer m_write_buffer{m_req_pool};    // Write request buffer
+    ReqBuffer m_aim_buffer{m_req_pool};      // AiM request buffer
+
+    ActiveBankTracker m_active_banks; // Banks of the requests in the active buffer
+
+    // Host reads and writes are addressed by their location in the device, not by addr
+    WriteIndex<AddrVec_t, AddrVecHash> m_write_index; // Writes from their enqueue until they leave pending_writes
 
     int m_row_addr_idx = -1;
 
@@ -25,6 +50,11 @@ private:
     float m_wr_high_watermark;
     bool m_is_write_mode = false;
 
+    Arbitration m_arbitration = Arbitration::Exclusive;
+    int m_AiM_weight = 1;
+    int m_host_weight = 1;
+    int m_arbitration_credit = 0; // Weighted: grants so far in the current round of m_AiM_weight + m_host_weight
+
     std::vector<IControllerPlugin *> m_plugins;
 
     size_t s_num_row_hits = 0;
@@ -37,15 +67,47 @@ private:
     int s_num_idle_cycles = 0;
     int s_num_active_cycles = 0;
     int s_num_precharged_cycles = 0;
+    int s_num_TMOD_cycles = 0;
+    int s_num_forwarded_reads = 0;
+    int s_num_refresh_ACT16s = 0;
 
     bool is_reg_RW_mode = false;
+    int m_TMOD_command = -1;
+    Clk_t m_last_TMOD_clk = -1; // Clock of a TMOD that no command has followed yet
+
+    int m_ACT16_command = -1;
+    Addr_t m_ACT16_row = -1;           // The row opened by the last ACT16, while no command has closed it
+    Addr_t m_refresh_closed_row = -1; // The row of the last ACT16 if a refresh closed it, while no row has been opened since
+
+    bool m_is_tick_active = true; // Did the last tick change the controller state?
+    bool m_is_tick_idle = false;  // Was the last tick counted as an idle cycle?
 
 public:
     void init() override {
         m_wr_low_watermark = param<float>("wr_low_watermark").desc("Threshold for switching back to read mode.").default_val(0.2f);
         m_wr_high_watermark = param<float>("wr_high_watermark").desc("Threshold for switching to write mode.").default_val(0.8f);
+        m_read_buffer.max_size = param<size_t>("buffer_size").desc("Capacity of the read and write request buffers.").default_val(32);
+        m_write_buffer.max_size = m_read_buffer.max_size;
         m_clock_ratio = param<uint>("clock_ratio").required();
 
+        std::string arbitration = param<std::string>("arbitration").desc("Sharing of the channel between AiM and read/write requests (Exclusive, AiMFirst, HostFirst, or Weighted).").default_val("Exclusive");
+        if (arbitration == "Exclusive") {
+            m_arbitration = Arbitration::Exclusive;
+        } else if (arbitration == "AiMFirst") {
+            m_arbitration = Arbitration::AiMFirst;
+        } else if (arbitration == "HostFirst") {
+            m_arbitration = Arbitration::HostFirst;
+        } else if (arbitration == "Weighted") {
+            m_arbitration = Arbitration::Weighted;
+        } else {
+            throw ConfigurationError("AiMDRAMController: unknown arbitration policy {}!", arbitration);
+        }
+        m_AiM_weight = param<int>("aim_weight").desc("Weighted arbitration: AiM requests served per round when both classes are ready.").default_val(1);
+        m_host_weight = param<int>("host_weight").desc("Weighted arbitration: read/write requests served per round when both classes are ready.").default_val(1);
+        if ((m_AiM_weight < 1) || (m_host_weight < 1)) {
+            throw ConfigurationError("AiMDRAMController: arbitration weights ({}, {}) must be positive!", m_AiM_weight, m_host_weight);
+        }
+
         m_scheduler = create_child_ifce<IScheduler>();
         m_refresh = create_child_ifce<IRefreshManager>();
 
@@ -60,7 +122,14 @@ public:
     void setup(IFrontEnd *frontend, IMemorySystem *memory_system) override {
         m_dram = memory_system->get_ifce<IDRAM>();
         m_row_addr_idx = m_dram->m_levels("row");
+        m_TMOD_command = m_dram->m_commands("TMOD");
+        m_ACT16_command = m_dram->m_commands("ACT16");
+        m_active_banks.setup(m_dram);
         m_priority_buffer.max_size = 512 * 3 + 32;
+        pending_reads.max_size = std::numeric_limits<size_t>::max();
+        pending_writes.max_size = std::numeric_limits<size_t>::max();
+        pending_reads.is_ordered_by_depart = true;
+        pending_writes.is_ordered_by_depart = true;
         m_logger = Logging::create_logger("AiMDRAMController[" + std::to_string(m_channel_id) + "]");
 
         for (const auto type : {Type::Read, Type::Write}) {
@@ -96,9 +165,41 @@ public:
         register_stat(s_num_precharged_cycles)
             .name(fmt::format("CH{}_precharged_cycles", m_channel_id))
             .desc(fmt::format("total number of precharged cycles"));
+
+        register_stat(s_num_TMOD_cycles)
+            .name(fmt::format("CH{}_TMOD_cycles", m_channel_id))
+            .desc(fmt::format("total number of cycles between a TMOD and the next command"));
+
+        register_stat(s_num_forwarded_reads)
+            .name(fmt::format("CH{}_num_forwarded_reads", m_channel_id))
+            .desc(fmt::format("total number of reads served by an in-flight write"));
+
+        register_stat(s_num_refresh_ACT16s)
+            .name(fmt::format("CH{}_num_refresh_ACT16s", m_channel_id))
+            .desc(fmt::format("total number of ACT16s that reopen a row closed by a refresh"));
     };
 
-    bool compare_addr_vec(Request req1, Request req2, int min_compared_level) {
+    /**
+     * @brief    Counts the ACT16s that only reopen the rows of the channel because a refresh closed them
+     * 
+     */
+    void track_refresh_reactivation(ReqBuffer::iterator req_it, ReqBuffer *buffer) {
+        const auto &meta = m_dram->m_command_meta(req_it->command);
+        if (meta.is_opening) {
+            Addr_t row = (req_it->command == m_ACT16_command) ? req_it->addr_vec[m_row_addr_idx] : -1;
+            if ((row != -1) && (row == m_refresh_closed_row)) {
+                s_num_refresh_ACT16s++;
+            }
+            m_ACT16_row = row;
+            m_refresh_closed_row = -1;
+        } else if (meta.is_closing) {
+            // Maintenance requests (e.g., refresh) are only served from the priority buffer
+            m_refresh_closed_row = (buffer == &m_priority_buffer) ? m_ACT16_row : -1;
+            m_ACT16_row = -1;
+        }
+    }
+
+    bool compare_addr_vec(const Request &req1, const Request &req2, int min_compared_level) {
         for (int level_idx = m_dram->m_levels("channel"); level_idx <= min_compared_level; level_idx++) {
             if (req1.addr_vec[level_idx] == -1)
                 return true;
@@ -112,24 +213,22 @@ public:
 
     bool send(Request &req) override {
         if (req.type == Type::AIM) {
-            if ((m_write_buffer.size() != 0) || (m_read_buffer.size() != 0))
+            if (!is_AiM_request_accepted(req))
                 return false;
             req.final_command = m_dram->m_aim_request_translations((int)req.opcode);
         } else {
-            if (m_aim_buffer.size() != 0)
+            if (!is_RW_request_accepted(req))
                 return false;
             req.final_command = m_dram->m_request_translations((int)req.type);
         }
 
         // Forward existing write requests to incoming read requests
         if (req.type == Type::Read) {
-            auto compare_addr = [req](const Request &wreq) {
-                return wreq.addr == req.addr;
-            };
-            if (std::find_if(m_write_buffer.begin(), m_write_buffer.end(), compare_addr) != m_write_buffer.end()) {
+            if (m_write_index.contains(req.addr_vec)) {
                 // The request will depart at the next cycle
                 req.depart = m_clk + 1;
-                pending_reads.push_back(req);
+                pending_reads.enqueue(req);
+                s_num_forwarded_reads++;
                 return true;
             }
         }
@@ -151,6 +250,9 @@ public:
             req.arrive = -1;
             return false;
         }
+        if (req.type == Type::Write) {
+            m_write_index.add(req.addr_vec);
+        }
 
         return true;
     };
@@ -166,20 +268,38 @@ public:
         return is_success;
     }
 
+    size_t get_num_priority_requests() override {
+        return m_priority_buffer.size();
+    };
+
+    bool is_idle() override {
+        return (m_active_buffer.size() == 0) && (m_priority_buffer.size() == 0) && (m_read_buffer.size() == 0) && (m_write_buffer.size() == 0) && (m_aim_buffer.size() == 0);
+    };
+
+    bool is_at_sync_boundary() override {
+        // SYNC and EOC are never bypassed, so every older AiM request has been served once one is at the head
+        bool is_AiM_drained = (m_aim_buffer.size() == 0) || is_barrier(*m_aim_buffer.begin());
+        return is_AiM_drained && (m_active_buffer.size() == 0) && (m_read_buffer.size() == 0) && (m_write_buffer.size() == 0);
+    };
+
     void tick() override {
         m_clk++;
         // if ((m_clk == 1) || (m_clk % 1000 == 0))
         //     m_logger->info("[CLK {}]", m_clk);
 
         // 1. Serve completed reads
-        serve_completed_reqs();
+        m_is_tick_active = serve_completed_reqs();
+        m_is_tick_idle = false;
 
+        size_t num_priority_reqs = m_priority_buffer.size();
         m_refresh->tick();
+        m_is_tick_active |= (m_priority_buffer.size() != num_priority_reqs);
 
         // 2. Try to find a request to serve.
         ReqBuffer::iterator req_it;
         ReqBuffer *buffer = nullptr;
         bool request_found = schedule_request(req_it, buffer);
+        m_is_tick_active |= request_found;
 
         // // 3. Update all plugins
         // for (auto plugin : m_plugins) {
@@ -189,9 +309,9 @@ public:
         // 4. Finally, issue the commands to serve the request
         if (request_found) {
             if ((req_it->opcode == Opcode::ISR_EOC) || (req_it->opcode == Opcode::ISR_SYNC)) {
-                req_it->depart = m_clk;
-                pending_reads.push_back(*req_it);
-                buffer->remove(req_it);
+                // Behind every in-flight read, so that it is only called back once they have been
+                req_it->depart = (pending_reads.size() == 0) ? m_clk : std::max(m_clk, pending_reads.back().depart);
+                buffer->move_to(req_it, pending_reads);
                 // m_logger->info("[CLK {}] EOC/SYNC ready for callback", m_clk);
             } else {
 
@@ -204,7 +324,7 @@ public:
                 }
 
                 if (requires_reg_RW_mode ^ is_reg_RW_mode) {
-                    req_it->command = m_dram->m_commands("TMOD");
+                    req_it->command = m_TMOD_command;
                     is_reg_RW_mode = !is_reg_RW_mode;
                 }
 
@@ -215,16 +335,21 @@ public:
                 m_dram->issue_command(req_it->command, req_it->addr_vec);
                 s_num_commands[req_it->command] += 1;
 
+                // The request was ready when its TMOD was issued, so it only waited for the mode switch (nMODCH)
+                if (m_last_TMOD_clk != -1) {
+                    s_num_TMOD_cycles += m_clk - m_last_TMOD_clk - 1;
+                    m_last_TMOD_clk = -1;
+                }
+                if (req_it->command == m_TMOD_command) {
+                    m_last_TMOD_clk = m_clk;
+                }
+                track_refresh_reactivation(req_it, buffer);
+
                 // If we are issuing the last command, set depart clock cycle and move the request to the pending_reads queue
                 if (req_it->command == req_it->final_command) {
                     int latency = m_dram->m_command_latencies(req_it->command);
                     assert(latency > 0);
                     req_it->depart = m_clk + latency;
-                    if (req_it->is_reader()) {
-                        pending_reads.push_back(*req_it);
-                    } else {
-                        pending_writes.push_back(*req_it);
-                    }
                     if (req_it->type == Type::AIM) {
                         s_num_AiM_cycles[req_it->opcode] += (m_clk - req_it->issue);
                     } else {
@@ -233,11 +358,20 @@ public:
                     // else if (req_it->type == Type::Write) {
                     //     // TODO: Add code to update statistics
                     // }
-                    buffer->remove(req_it);
+                    if (buffer == &m_active_buffer) {
+                        m_active_banks.remove(*req_it);
+                    }
+                    if (req_it->is_reader()) {
+                        buffer->move_to(req_it, pending_reads);
+                    } else {
+                        buffer->move_to(req_it, pending_writes);
+                    }
                 } else if (req_it->type != Type::AIM) {
                     if (m_dram->m_command_meta(req_it->command).is_opening) {
-                        m_active_buffer.enqueue(*req_it);
-                        buffer->remove(req_it);
+                        if (buffer != &m_active_buffer) {
+                            m_active_banks.add(*req_it);
+                        }
+                        buffer->move_to(req_it, m_active_buffer);
                     }
                 }
             }
@@ -245,6 +379,7 @@ public:
             // if (m_channel_id == 0)
             // m_logger->info("[CLK {}] CH0 IDLE", m_clk);
             s_num_idle_cycles += 1;
+            m_is_tick_idle = true;
         }
 
         if (m_dram->m_open_rows[m_channel_id] == 0) {
@@ -254,47 +389,152 @@ public:
         }
     };
 
+    Clk_t get_skippable_cycles() override {
+        if (m_is_tick_active) {
+            return 0;
+        }
+
+        // Nothing was issued or retired in the last tick, so nothing changes until a buffered request becomes ready,
+        // an in-flight request departs, or a refresh is due. A request that is ready but was not scheduled keeps
+        // the controller ticking.
+        Clk_t next_event_clk = std::numeric_limits<Clk_t>::max();
+        for (auto buffer : {&m_active_buffer, &m_priority_buffer, &m_read_buffer, &m_write_buffer, &m_aim_buffer}) {
+            for (auto &req : *buffer) {
+                if ((req.opcode == Opcode::ISR_EOC) || (req.opcode == Opcode::ISR_SYNC)) {
+                    // Only waits for the pending writes
+                    continue;
+                }
+                int command = m_dram->get_preq_command(req);
+                next_event_clk = std::min(next_event_clk, std::max(m_dram->earliest_ready_clk(command, req.addr_vec), m_clk + 1));
+            }
+        }
+        if (pending_reads.size() && (pending_reads.begin()->depart > m_clk)) {
+            next_event_clk = std::min(next_event_clk, pending_reads.begin()->depart);
+        }
+        if (pending_writes.size()) {
+            next_event_clk = std::min(next_event_clk, pending_writes.begin()->depart);
+        }
+
+        Clk_t skippable_cycles = std::min(next_event_clk - m_clk - 1, m_refresh->get_skippable_cycles());
+        return std::max(skippable_cycles, (Clk_t)0);
+    };
+
+    void skip_cycles(Clk_t num_cycles) override {
+        m_clk += num_cycles;
+        m_refresh->skip_cycles(num_cycles);
+
+        // The skipped cycles repeat the last tick
+        if (m_is_tick_idle) {
+            s_num_idle_cycles += num_cycles;
+        }
+        if (m_dram->m_open_rows[m_channel_id] == 0) {
+            s_num_precharged_cycles += num_cycles;
+        } else {
+            s_num_active_cycles += num_cycles;
+        }
+    };
+
 private:
+    static bool is_barrier(const Request &req) {
+        return (req.opcode == Opcode::ISR_EOC) || (req.opcode == Opcode::ISR_SYNC);
+    }
+
+    bool requires_mode_switch(const Request &req) {
+        bool requires_reg_RW_mode = (req.type == Type::AIM) && AiMISRInfo::opcode_requires_reg_RW_mod(req.opcode);
+        return requires_reg_RW_mode != is_reg_RW_mode;
+    }
+
+    /**
+     * @brief    Checks if two requests touch the same row of a bank (-1 matches any bank)
+     * 
+     */
+    bool is_row_hazard(const Request &req1, const Request &req2) {
+        int row = req1.addr_vec[m_row_addr_idx];
+        return (row != -1) && (row == req2.addr_vec[m_row_addr_idx]) && compare_addr_vec(req1, req2, m_row_addr_idx - 1);
+    }
+
+    /**
+     * @brief    Checks if an AiM request can be buffered next to the read and write requests
+     * @details
+     * SYNC and EOC must not complete before the read and write requests sent ahead of them, so they always wait for
+     * the read and write buffers to drain.
+     * 
+     */
+    bool is_AiM_request_accepted(const Request &req) {
+        if (m_arbitration == Arbitration::Exclusive) {
+            return (m_write_buffer.size() == 0) && (m_read_buffer.size() == 0);
+        }
+        if (is_barrier(req)) {
+            return (m_write_buffer.size() == 0) && (m_read_buffer.size() == 0) && (m_active_buffer.size() == 0);
+        }
+        for (auto buffer : {&m_active_buffer, &m_read_buffer, &m_write_buffer}) {
+            for (const auto &rw_req : *buffer) {
+                if (is_row_hazard(req, rw_req)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief    Checks if a read or write request can be buffered next to the AiM requests
+     * 
+     */
+    bool is_RW_request_accepted(const Request &req) {
+        if (m_arbitration == Arbitration::Exclusive) {
+            return m_aim_buffer.size() == 0;
+        }
+        for (const auto &aim_req : m_aim_buffer) {
+            if (is_barrier(aim_req) || is_row_hazard(req, aim_req)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     /**
      * @brief    Helper function to serve the completed read requests
      * @details
      * This function is called at the beginning of the tick() function.
-     * It checks the pending_reads queue to see if the top request has received data from DRAM.
-     * If so, it finishes this request by calling its callback and poping it from the pending_reads queue.
+     * The pending queues are sorted by depart, so every request that has received its data from DRAM is at the front
+     * of pending_reads. They are called back in departure order and popped. An EOC/SYNC additionally waits until
+     * pending_writes is empty, and holds back the requests that depart after it. Then, the completed writes retire.
+     * Returns whether any request was retired.
      */
-    void serve_completed_reqs() {
-        if (pending_reads.size()) {
-            // Check the first pending_reads request
-            auto &req = pending_reads[0];
-            if (req.depart <= m_clk) {
-                // Request received data from dram
-
-                if (((req.opcode != Opcode::ISR_EOC) && (req.opcode != Opcode::ISR_SYNC)) ||
-                    (pending_writes.size() == 0)) {
-
-                    if (req.callback) {
-                        // If the request comes from outside (e.g., processor), call its callback
-                        // m_logger->info("[CLK {}] Calling back {}!", m_clk, req.str());
-                        req.callback(req);
-                    }
-                    // else {
-                    //     m_logger->info("[CLK {}] Warning: {} doesn't have callback set but it is in the pending_reads queue!", m_clk, req.str());
-                    // }
-                    // Finally, r emove this request from the pending_reads queue
-                    pending_reads.pop_front();
-                }
+    bool serve_completed_reqs() {
+        bool is_served = false;
+        while (pending_reads.size()) {
+            auto &req = *pending_reads.begin();
+            if (req.depart > m_clk) {
+                break;
+            }
+            if (((req.opcode == Opcode::ISR_EOC) || (req.opcode == Opcode::ISR_SYNC)) && (pending_writes.size() != 0)) {
+                break;
+            }
+
+            if (req.callback) {
+                // If the request comes from outside (e.g., processor), call its callback
+                // m_logger->info("[CLK {}] Calling back {}!", m_clk, req.str());
+                req.callback(req);
             }
+            // else {
+            //     m_logger->info("[CLK {}] Warning: {} doesn't have callback set but it is in the pending_reads queue!", m_clk, req.str());
+            // }
+            // Finally, remove this request from the pending_reads queue
+            pending_reads.remove(pending_reads.begin());
+            is_served = true;
         }
-        auto write_req_it = pending_writes.begin();
-        while (write_req_it != pending_writes.end()) {
-            if (write_req_it->depart <= m_clk) {
-                // Remove this write request
-                // m_logger->info("[CLK {}] Finished {}!", m_clk, write_req_it->str());
-                write_req_it = pending_writes.erase(write_req_it);
-            } else {
-                ++write_req_it;
+        while (pending_writes.size() && (pending_writes.begin()->depart <= m_clk)) {
+            // Remove this write request
+            // m_logger->info("[CLK {}] Finished {}!", m_clk, pending_writes.begin()->str());
+            if (pending_writes.begin()->type == Type::Write) {
+                m_write_index.remove(pending_writes.begin()->addr_vec);
             }
+            pending_writes.remove(pending_writes.begin());
+            is_served = true;
         }
+        return is_served;
     };
 
     /**
@@ -334,7 +574,7 @@ private:
             if (m_priority_buffer.size() != 0) {
                 req_buffer = &m_priority_buffer;
                 req_it = m_priority_buffer.begin();
-                req_it->command = m_dram->get_preq_command(req_it->final_command, req_it->addr_vec);
+                req_it->command = m_dram->get_preq_command(*req_it);
 
                 request_found = m_dram->check_ready(req_it->command, req_it->addr_vec);
                 if ((request_found == false) & (m_priority_buffer.size() != 0)) {
@@ -347,28 +587,21 @@ private:
 
             // 2.2.1    If no request to be scheduled in the priority buffer, check the read and write OR AiM buffers.
             if (!request_found) {
+                if (m_arbitration != Arbitration::Exclusive) {
+                    return schedule_shared_request(req_it, req_buffer);
+                }
                 if (m_aim_buffer.size() != 0) {
-                    req_it = m_aim_buffer.begin();
-                    if ((req_it->opcode == Opcode::ISR_EOC) || (req_it->opcode == Opcode::ISR_SYNC)) {
-                        req_buffer = &m_aim_buffer;
+                    req_buffer = &m_aim_buffer;
+                    request_found = get_AiM_request(req_it);
+                    if (is_barrier(*req_it)) {
                         // m_logger->info("[CLK {}] 1- Found AiM request in buffer: {}", m_clk, req_it->str());
                         return true;
-                    } else {
-                        req_it->command = m_dram->get_preq_command(req_it->final_command, req_it->addr_vec);
-                        request_found = m_dram->check_ready(req_it->command, req_it->addr_vec);
-                        req_buffer = &m_aim_buffer;
-                        // if (request_found) {
-                        //     m_logger->info("[CLK {}] 2- Found AiM request in buffer: {}", m_clk, req_it->str());
-                        // }
                     }
+                    // if (request_found) {
+                    //     m_logger->info("[CLK {}] 2- Found AiM request in buffer: {}", m_clk, req_it->str());
+                    // }
                 } else {
-                    // Query the write policy to decide which buffer to serve
-                    set_write_mode();
-                    auto &buffer = m_is_write_mode ? m_write_buffer : m_read_buffer;
-                    if (req_it = m_scheduler->get_best_request(buffer); req_it != buffer.end()) {
-                        request_found = m_dram->check_ready(req_it->command, req_it->addr_vec);
-                        req_buffer = &buffer;
-                    }
+                    request_found = get_RW_request(req_it, req_buffer);
                     // if (request_found) {
                     //     m_logger->info("[CLK {}] Found request in general buffers: {}", m_clk, req_it->str());
                     // }
@@ -377,22 +610,131 @@ private:
         }
 
         // 2.3 If we find a request to schedule, we need to check if it will close an opened row in the active buffer.
-        if (request_found) {
-            if (m_dram->m_command_meta(req_it->command).is_closing) {
-                std::vector<Addr_t> rowgroup((req_it->addr_vec).begin(), (req_it->addr_vec).begin() + m_row_addr_idx);
-
-                // Search the active buffer with the row address (inkl. banks, etc.)
-                for (auto _it = m_active_buffer.begin(); _it != m_active_buffer.end(); _it++) {
-                    std::vector<Addr_t> _it_rowgroup(_it->addr_vec.begin(), _it->addr_vec.begin() + m_row_addr_idx);
-                    if (rowgroup == _it_rowgroup) {
-                        // Invalidate this scheduling outcome if we are to interrupt a request in the active buffer
-                        request_found = false;
-                    }
+        if (request_found && is_closing_started_row(req_it)) {
+            request_found = false;
+        }
+
+        return request_found;
+    }
+
+    /**
+     * @brief    Finds the AiM request to serve next and returns whether it is ready
+     * 
+     */
+    bool get_AiM_request(ReqBuffer::iterator &req_it) {
+        // In order, unless the scheduler tracks the AiM hazards
+        req_it = m_scheduler->get_best_AiM_request(m_aim_buffer, is_reg_RW_mode);
+        if (is_barrier(*req_it)) {
+            return true;
+        }
+        req_it->command = m_dram->get_preq_command(*req_it);
+        return m_dram->check_ready(req_it->command, req_it->addr_vec);
+    }
+
+    /**
+     * @brief    Finds the read or write request to serve next and returns whether it is ready
+     * 
+     */
+    bool get_RW_request(ReqBuffer::iterator &req_it, ReqBuffer *&req_buffer) {
+        // Query the write policy to decide which buffer to serve
+        set_write_mode();
+        auto &buffer = m_is_write_mode ? m_write_buffer : m_read_buffer;
+        if (req_it = m_scheduler->get_best_request(buffer); req_it != buffer.end()) {
+            req_buffer = &buffer;
+            return m_dram->check_ready(req_it->command, req_it->addr_vec);
+        }
+        return false;
+    }
+
+    /**
+     * @brief    Picks between the AiM and the read/write candidates when both classes share the channel
+     * @details
+     * A class with a ready candidate that does not close a row in use is served. If both classes have one, the
+     * arbitration policy decides. Weighted only advances its round once the granted request issues its own command:
+     * a grant that only switches the register mode with TMOD is repeated, otherwise the two classes could keep
+     * toggling the mode without ever issuing.
+     * 
+     */
+    bool schedule_shared_request(ReqBuffer::iterator &req_it, ReqBuffer *&req_buffer) {
+        ReqBuffer::iterator AiM_it;
+        bool is_AiM_ready = false;
+        if (m_aim_buffer.size() != 0) {
+            is_AiM_ready = get_AiM_request(AiM_it);
+            if (is_barrier(*AiM_it)) {
+                // Only buffered once the read and write requests have drained
+                req_it = AiM_it;
+                req_buffer = &m_aim_buffer;
+                return true;
+            }
+            is_AiM_ready = is_AiM_ready && !is_closing_started_row(AiM_it);
+        }
+
+        ReqBuffer::iterator RW_it;
+        ReqBuffer *RW_buffer = nullptr;
+        bool is_RW_ready = false;
+        if ((m_read_buffer.size() != 0) || (m_write_buffer.size() != 0)) {
+            is_RW_ready = get_RW_request(RW_it, RW_buffer) && !is_closing_started_row(RW_it) && !is_closing_started_AiM_row(RW_it);
+        }
+
+        bool is_AiM_granted = is_AiM_ready;
+        if (is_AiM_ready && is_RW_ready) {
+            switch (m_arbitration) {
+            case Arbitration::AiMFirst: {
+                is_AiM_granted = true;
+                break;
+            }
+            case Arbitration::HostFirst: {
+                is_AiM_granted = false;
+                break;
+            }
+            default: {
+                is_AiM_granted = (m_arbitration_credit < m_AiM_weight);
+                if (!requires_mode_switch(is_AiM_granted ? *AiM_it : *RW_it)) {
+                    m_arbitration_credit = (m_arbitration_credit + 1) % (m_AiM_weight + m_host_weight);
                 }
+                break;
+            }
             }
         }
 
-        return request_found;
+        if (is_AiM_granted) {
+            req_it = AiM_it;
+            req_buffer = &m_aim_buffer;
+            return true;
+        }
+        if (is_RW_ready) {
+            req_it = RW_it;
+            req_buffer = RW_buffer;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief    Checks if the command of a request closes the row of a request in the active buffer (-1 matches any bank)
+     * 
+     */
+    bool is_closing_started_row(ReqBuffer::iterator req_it) {
+        return m_dram->m_command_meta(req_it->command).is_closing && m_active_banks.is_any_bank_active(req_it->addr_vec);
+    }
+
+    /**
+     * @brief    Checks if the command of a read or write request closes a row that a started AiM request still needs
+     * @details
+     * Started AiM requests stay in the AiM buffer instead of moving to the active buffer. Refreshes are not held back
+     * by them: the AiM request reopens its row afterwards.
+     * 
+     */
+    bool is_closing_started_AiM_row(ReqBuffer::iterator req_it) {
+        if (!m_dram->m_command_meta(req_it->command).is_closing) {
+            return false;
+        }
+        for (const auto &aim_req : m_aim_buffer) {
+            if ((aim_req.issue != -1) && (aim_req.addr_vec[m_row_addr_idx] != -1) && compare_addr_vec(*req_it, aim_req, m_row_addr_idx - 1)) {
+                return true;
+            }
+        }
+        return false;
     }
 };
 
@@ -1,4 +1,6 @@
+#include "dram_controller/bank_tracker.h"
 #include "dram_controller/controller.h"
+#include "dram_controller/write_index.h"
 #include "memory_system/memory_system.h"
 
 namespace Ramulator {
@@ -9,10 +11,15 @@ class GenericDRAMController final : public IDRAMController, public Implementatio
 private:
     std::deque<Request> pending; // A queue for read requests that are about to finish (callback after RL)
 
-    ReqBuffer m_active_buffer;   // Buffer for requests being served. This has the highest priority
-    ReqBuffer m_priority_buffer; // Buffer for high-priority requests (e.g., maintenance like refresh).
-    ReqBuffer m_read_buffer;     // Read request buffer
-    ReqBuffer m_write_buffer;    // Write request buffer
+    ReqPool m_req_pool; // Storage of the buffered requests, so that they move between buffers in place
+
+    ReqBuffer m_active_buffer{m_req_pool};   // Buffer for requests being served. This has the highest priority
+    ReqBuffer m_priority_buffer{m_req_pool}; // Buffer for high-priority requests (e.g., maintenance like refresh).
+    ReqBuffer m_read_buffer{m_req_pool};     // Read request buffer
+    ReqBuffer m_write_buffer{m_req_pool};    // Write request buffer
+
+    ActiveBankTracker m_active_banks; // Banks of the requests in the active buffer
+    WriteIndex<Addr_t> m_write_index; // Writes from their enqueue until their last command
 
     int m_row_addr_idx = -1;
 
@@ -25,11 +32,14 @@ private:
     size_t s_num_row_hits = 0;
     size_t s_num_row_misses = 0;
     size_t s_num_row_conflicts = 0;
+    size_t s_num_forwarded_reads = 0;
 
 public:
     void init() override {
         m_wr_low_watermark = param<float>("wr_low_watermark").desc("Threshold for switching back to read mode.").default_val(0.2f);
         m_wr_high_watermark = param<float>("wr_high_watermark").desc("Threshold for switching to write mode.").default_val(0.8f);
+        m_read_buffer.max_size = param<size_t>("buffer_size").desc("Capacity of the read and write request buffers.").default_val(32);
+        m_write_buffer.max_size = m_read_buffer.max_size;
 
         m_scheduler = create_child_ifce<IScheduler>();
         m_refresh = create_child_ifce<IRefreshManager>();
@@ -46,6 +56,11 @@ public:
         m_dram = memory_system->get_ifce<IDRAM>();
         m_row_addr_idx = m_dram->m_levels("row");
         m_priority_buffer.max_size = 512 * 3 + 32;
+        m_active_banks.setup(m_dram);
+
+        register_stat(s_num_forwarded_reads)
+            .name(fmt::format("CH{}_num_forwarded_reads", m_channel_id))
+            .desc(fmt::format("total number of reads served by an in-flight write"));
     };
 
     bool send(Request &req) override {
@@ -53,13 +68,11 @@ public:
 
         // Forward existing write requests to incoming read requests
         if (req.type == Type::Read) {
-            auto compare_addr = [req](const Request &wreq) {
-                return wreq.addr == req.addr;
-            };
-            if (std::find_if(m_write_buffer.begin(), m_write_buffer.end(), compare_addr) != m_write_buffer.end()) {
+            if (m_write_index.contains(req.addr)) {
                 // The request will depart at the next cycle
                 req.depart = m_clk + 1;
                 pending.push_back(req);
+                s_num_forwarded_reads++;
                 return true;
             }
         }
@@ -79,6 +92,9 @@ public:
             req.arrive = -1;
             return false;
         }
+        if (req.type == Type::Write) {
+            m_write_index.add(req.addr);
+        }
 
         return true;
     };
@@ -91,6 +107,14 @@ public:
         return is_success;
     }
 
+    size_t get_num_priority_requests() override {
+        return m_priority_buffer.size();
+    };
+
+    bool is_idle() override {
+        return (m_active_buffer.size() == 0) && (m_priority_buffer.size() == 0) && (m_read_buffer.size() == 0) && (m_write_buffer.size() == 0);
+    };
+
     void tick() override {
         m_clk++;
 
@@ -121,12 +145,18 @@ public:
                     pending.push_back(*req_it);
                 } else if (req_it->type == Type::Write) {
                     // TODO: Add code to update statistics
+                    m_write_index.remove(req_it->addr);
+                }
+                if (buffer == &m_active_buffer) {
+                    m_active_banks.remove(*req_it);
                 }
                 buffer->remove(req_it);
             } else {
                 if (m_dram->m_command_meta(req_it->command).is_opening) {
-                    m_active_buffer.enqueue(*req_it);
-                    buffer->remove(req_it);
+                    if (buffer != &m_active_buffer) {
+                        m_active_banks.add(*req_it);
+                    }
+                    buffer->move_to(req_it, m_active_buffer);
                 }
             }
         }
@@ -197,7 +227,7 @@ private:
             if (m_priority_buffer.size() != 0) {
                 req_buffer = &m_priority_buffer;
                 req_it = m_priority_buffer.begin();
-                req_it->command = m_dram->get_preq_command(req_it->final_command, req_it->addr_vec);
+                req_it->command = m_dram->get_preq_command(*req_it);
 
                 request_found = m_dram->check_ready(req_it->command, req_it->addr_vec);
                 if ((request_found == false) & (m_priority_buffer.size() != 0)) {
@@ -219,17 +249,9 @@ private:
 
         // 2.3 If we find a request to schedule, we need to check if it will close an opened row in the active buffer.
         if (request_found) {
-            if (m_dram->m_command_meta(req_it->command).is_closing) {
-                std::vector<Addr_t> rowgroup((req_it->addr_vec).begin(), (req_it->addr_vec).begin() + m_row_addr_idx);
-
-                // Search the active buffer with the row address (inkl. banks, etc.)
-                for (auto _it = m_active_buffer.begin(); _it != m_active_buffer.end(); _it++) {
-                    std::vector<Addr_t> _it_rowgroup(_it->addr_vec.begin(), _it->addr_vec.begin() + m_row_addr_idx);
-                    if (rowgroup == _it_rowgroup) {
-                        // Invalidate this scheduling outcome if we are to interrupt a request in the active buffer
-                        request_found = false;
-                    }
-                }
+            if (m_dram->m_command_meta(req_it->command).is_closing && m_active_banks.is_bank_active(req_it->addr_vec)) {
+                // Invalidate this scheduling outcome if we are to interrupt a request in the active buffer
+                request_found = false;
             }
         }
 
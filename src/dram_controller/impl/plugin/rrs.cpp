@@ -363,7 +363,7 @@ class RRS : public IControllerPlugin, public Implementation {
 
     void issue_swap(ReqBuffer::iterator& req_it, int src_row, int dst_row) {
       // load addr_vec
-      std::vector<int> addr_vec;
+      AddrVec_t addr_vec;
       for (int i = 0; i < req_it->addr_vec.size(); i++){
         addr_vec.push_back(req_it->addr_vec[i]);
       }
@@ -0,0 +1,147 @@
+#include <vector>
+
+#include "base/base.h"
+#include "base/request.h"
+#include "dram_controller/controller.h"
+#include "dram_controller/refresh.h"
+
+namespace Ramulator {
+
+/**
+ * @brief    All-bank refresh scheme that avoids interrupting AiM kernels
+ * @details
+ * A refresh is due every nREFI cycles as in AllBankRefresh. A due refresh is deferred until the controller reaches a
+ * SYNC or EOC boundary, or until all banks of the channel are closed (between two rows), so that the rows of an AiM
+ * operation in progress are not closed and reactivated. Once max_postponed refreshes are owed, the next one is sent
+ * regardless.
+ * 
+ * By default, all channels are due at the same cycles, so that they refresh within the same kernel and a SYNC only
+ * waits for one nRFC. With stagger_channels, the channels are spread over nREFI instead, which suits channels that
+ * rarely synchronize.
+ * 
+ */
+class AiMAllBankRefresh : public IRefreshManager, public Implementation {
+    RAMULATOR_REGISTER_IMPLEMENTATION(IRefreshManager, AiMAllBankRefresh, "AiMAllBank", "All-Bank Refresh scheme aligned with AiM SYNC boundaries.")
+private:
+    Clk_t m_clk = 0;
+    IDRAM *m_dram;
+    IDRAMController *m_ctrl;
+
+    int m_dram_org_levels = -1;
+    int m_num_ranks = -1;
+
+    int m_nrefi = -1;
+    int m_ref_req_id = -1;
+    int m_ref_command = -1;
+    Clk_t m_next_refresh_cycle = -1;
+
+    int m_max_postponed = -1;
+    bool m_stagger_channels = false;
+    int m_num_owed = 0; // Refreshes that are due but not sent yet
+
+    size_t s_num_sync_aligned_refreshes = 0;
+    size_t s_num_row_aligned_refreshes = 0;
+    size_t s_num_forced_refreshes = 0;
+
+public:
+    void init() override {
+        m_ctrl = cast_parent<IDRAMController>();
+        m_max_postponed = param<int>("max_postponed").desc("Maximum number of all-bank refreshes that can be owed.").default_val(8);
+        if (m_max_postponed < 1) {
+            throw ConfigurationError("AiMAllBankRefresh: max_postponed ({}) must be positive!", m_max_postponed);
+        }
+        m_stagger_channels = param<bool>("stagger_channels").desc("Spread the refreshes of the channels over the refresh interval.").default_val(false);
+    };
+
+    void setup(IFrontEnd *frontend, IMemorySystem *memory_system) override {
+        m_dram = m_ctrl->m_dram;
+
+        m_dram_org_levels = m_dram->m_levels.size();
+        // Devices without ranks refresh the whole channel at once
+        m_num_ranks = m_dram->m_levels.contains("rank") ? m_dram->get_level_size("rank") : 1;
+
+        m_nrefi = m_dram->m_timing_vals("nREFI");
+        m_ref_req_id = m_dram->m_requests("all-bank-refresh");
+        m_ref_command = m_dram->m_request_translations(m_ref_req_id);
+
+        m_next_refresh_cycle = m_nrefi;
+        if (m_stagger_channels) {
+            m_next_refresh_cycle += (Clk_t)m_nrefi * m_ctrl->m_channel_id / m_dram->get_level_size("channel");
+        }
+
+        register_stat(s_num_sync_aligned_refreshes)
+            .name(fmt::format("CH{}_num_sync_aligned_refreshes", m_ctrl->m_channel_id))
+            .desc("total number of all-bank refreshes sent at a SYNC or EOC boundary");
+        register_stat(s_num_row_aligned_refreshes)
+            .name(fmt::format("CH{}_num_row_aligned_refreshes", m_ctrl->m_channel_id))
+            .desc("total number of all-bank refreshes sent while all banks were closed");
+        register_stat(s_num_forced_refreshes)
+            .name(fmt::format("CH{}_num_forced_refreshes", m_ctrl->m_channel_id))
+            .desc("total number of all-bank refreshes sent at the postponement limit");
+    };
+
+    void tick() override {
+        m_clk++;
+
+        if (m_clk == m_next_refresh_cycle) {
+            m_next_refresh_cycle += m_nrefi;
+            m_num_owed++;
+        }
+
+        if ((m_num_owed == 0) || (m_ctrl->get_num_priority_requests() != 0)) {
+            // Nothing is due, or the previous refresh has not been served yet
+            return;
+        }
+
+        if (m_num_owed >= m_max_postponed) {
+            s_num_forced_refreshes++;
+        } else if (m_ctrl->is_at_sync_boundary()) {
+            s_num_sync_aligned_refreshes++;
+        } else if (are_all_banks_closed()) {
+            s_num_row_aligned_refreshes++;
+        } else {
+            return;
+        }
+
+        for (int r = 0; r < m_num_ranks; r++) {
+            Request req(get_rank_addr_vec(r), m_ref_req_id);
+            bool is_success = m_ctrl->priority_send(req);
+            if (!is_success) {
+                throw std::runtime_error("Failed to send refresh!");
+            }
+        }
+        m_num_owed--;
+    };
+
+    Clk_t get_skippable_cycles() override {
+        // Whether a refresh is sent only changes with the controller and device state, which do not change while
+        // the controller skips cycles
+        return m_next_refresh_cycle - m_clk - 1;
+    };
+
+    void skip_cycles(Clk_t num_cycles) override {
+        m_clk += num_cycles;
+    };
+
+private:
+    AddrVec_t get_rank_addr_vec(int rank_id) const {
+        AddrVec_t addr_vec(m_dram_org_levels, -1);
+        addr_vec[m_dram->m_levels("channel")] = m_ctrl->m_channel_id;
+        if (m_dram->m_levels.contains("rank")) {
+            addr_vec[m_dram->m_levels("rank")] = rank_id;
+        }
+        return addr_vec;
+    };
+
+    bool are_all_banks_closed() const {
+        for (int r = 0; r < m_num_ranks; r++) {
+            // The refresh only needs a precharge first if a bank is open
+            if (m_dram->get_preq_command(m_ref_command, get_rank_addr_vec(r)) != m_ref_command) {
+                return false;
+            }
+        }
+        return true;
+    };
+};
+
+} // namespace Ramulator
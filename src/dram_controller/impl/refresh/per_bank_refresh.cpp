@@ -0,0 +1,152 @@
+#include <vector>
+
+#include "base/base.h"
+#include "base/request.h"
+#include "dram_controller/controller.h"
+#include "dram_controller/refresh.h"
+
+namespace Ramulator {
+
+/**
+ * @brief    Per-bank refresh scheme
+ * @details
+ * Refreshes one bank of the channel every nREFI / (number of banks) cycles, in round-robin order, so that the other
+ * banks keep serving requests. A due refresh is postponed while its bank has an open row and the controller is busy
+ * (e.g., in the middle of a stream of AiM operations that keep all rows open), and sent as soon as the bank is closed
+ * or the controller has nothing else to do. Once max_postponed refreshes are owed, the next one is sent regardless.
+ * While the controller is idle and the next bank is closed, up to max_pulled_in refreshes are sent ahead of time.
+ * 
+ */
+class PerBankRefresh : public IRefreshManager, public Implementation {
+    RAMULATOR_REGISTER_IMPLEMENTATION(IRefreshManager, PerBankRefresh, "PerBank", "Per-Bank Refresh scheme.")
+private:
+    Clk_t m_clk = 0;
+    IDRAM *m_dram;
+    IDRAMController *m_ctrl;
+
+    int m_dram_org_levels = -1;
+    std::vector<int> m_bank_levels; // The levels between the channel and the row, outermost first
+    int m_num_banks = -1;
+
+    int m_nrefi_pb = -1;
+    int m_ref_req_id = -1;
+    int m_ref_command = -1;
+    Clk_t m_next_refresh_cycle = -1;
+
+    int m_max_postponed = -1;
+    int m_max_pulled_in = -1;
+    int m_num_owed = 0; // Refreshes that are due but not sent yet (negative if pulled in)
+    int m_next_bank = 0;
+
+    size_t s_num_postponed_refreshes = 0;
+    size_t s_num_forced_refreshes = 0;
+    size_t s_num_pulled_in_refreshes = 0;
+
+public:
+    void init() override {
+        m_ctrl = cast_parent<IDRAMController>();
+        m_max_postponed = param<int>("max_postponed").desc("Maximum number of per-bank refreshes that can be owed.").default_val(8);
+        m_max_pulled_in = param<int>("max_pulled_in").desc("Maximum number of per-bank refreshes that can be sent ahead of time.").default_val(8);
+        if (m_max_postponed < 1) {
+            throw ConfigurationError("PerBankRefresh: max_postponed ({}) must be positive!", m_max_postponed);
+        }
+        if (m_max_pulled_in < 0) {
+            throw ConfigurationError("PerBankRefresh: max_pulled_in ({}) must not be negative!", m_max_pulled_in);
+        }
+    };
+
+    void setup(IFrontEnd *frontend, IMemorySystem *memory_system) override {
+        m_dram = m_ctrl->m_dram;
+
+        if (!m_dram->m_requests.contains("per-bank-refresh")) {
+            throw ConfigurationError("PerBankRefresh: {} does not support per-bank refresh!", m_dram->get_name());
+        }
+        m_ref_req_id = m_dram->m_requests("per-bank-refresh");
+        m_ref_command = m_dram->m_request_translations(m_ref_req_id);
+
+        m_dram_org_levels = m_dram->m_levels.size();
+        m_num_banks = 1;
+        for (int level = m_dram->m_levels("channel") + 1; level < m_dram->m_levels("row"); level++) {
+            m_bank_levels.push_back(level);
+            m_num_banks *= m_dram->m_organization.count[level];
+        }
+
+        m_nrefi_pb = m_dram->m_timing_vals("nREFI") / m_num_banks;
+        if (m_nrefi_pb < 1) {
+            throw ConfigurationError("PerBankRefresh: nREFI ({}) of {} is shorter than one cycle per bank!", m_dram->m_timing_vals("nREFI"), m_dram->get_name());
+        }
+
+        m_next_refresh_cycle = m_nrefi_pb;
+
+        register_stat(s_num_postponed_refreshes)
+            .name(fmt::format("CH{}_num_postponed_refreshes", m_ctrl->m_channel_id))
+            .desc("total number of per-bank refreshes sent after they were due");
+        register_stat(s_num_forced_refreshes)
+            .name(fmt::format("CH{}_num_forced_refreshes", m_ctrl->m_channel_id))
+            .desc("total number of per-bank refreshes sent at the postponement limit");
+        register_stat(s_num_pulled_in_refreshes)
+            .name(fmt::format("CH{}_num_pulled_in_refreshes", m_ctrl->m_channel_id))
+            .desc("total number of per-bank refreshes sent before they were due");
+    };
+
+    void tick() override {
+        m_clk++;
+
+        bool is_due = (m_clk == m_next_refresh_cycle);
+        if (is_due) {
+            m_next_refresh_cycle += m_nrefi_pb;
+            m_num_owed++;
+        }
+
+        if (m_ctrl->get_num_priority_requests() != 0) {
+            // The previous refresh has not been served yet
+            return;
+        }
+
+        AddrVec_t addr_vec = get_bank_addr_vec(m_next_bank);
+        bool is_bank_closed = (m_dram->get_preq_command(m_ref_command, addr_vec) == m_ref_command);
+        bool is_idle = m_ctrl->is_idle();
+        if (m_num_owed >= m_max_postponed) {
+            s_num_forced_refreshes++;
+        } else if ((m_num_owed > 0) && (is_bank_closed || is_idle)) {
+            // On time only if it just became due and no older refresh is owed
+            s_num_postponed_refreshes += !(is_due && (m_num_owed == 1));
+        } else if ((m_num_owed > -m_max_pulled_in) && is_bank_closed && is_idle) {
+            s_num_pulled_in_refreshes++;
+        } else {
+            return;
+        }
+
+        Request req(addr_vec, m_ref_req_id);
+        bool is_success = m_ctrl->priority_send(req);
+        if (!is_success) {
+            throw std::runtime_error("Failed to send refresh!");
+        }
+        m_num_owed--;
+        m_next_bank = (m_next_bank + 1) % m_num_banks;
+    };
+
+    Clk_t get_skippable_cycles() override {
+        // Whether a refresh is sent only changes with the controller and device state, which do not change while
+        // the controller skips cycles
+        return m_next_refresh_cycle - m_clk - 1;
+    };
+
+    void skip_cycles(Clk_t num_cycles) override {
+        m_clk += num_cycles;
+    };
+
+private:
+    AddrVec_t get_bank_addr_vec(int bank_id) const {
+        AddrVec_t addr_vec(m_dram_org_levels, -1);
+        addr_vec[m_dram->m_levels("channel")] = m_ctrl->m_channel_id;
+        for (int i = m_bank_levels.size() - 1; i >= 0; i--) {
+            int count = m_dram->m_organization.count[m_bank_levels[i]];
+            addr_vec[m_bank_levels[i]] = bank_id % count;
+            bank_id /= count;
+        }
+        return addr_vec;
+    };
+};
+
+} // namespace Ramulator
@@ -1,21 +1,123 @@
+#include <cstdint>
 #include <vector>
 
 #include "base/base.h"
+#include "dram_controller/bank_tracker.h"
 #include "dram_controller/controller.h"
 #include "dram_controller/scheduler.h"
 
 namespace Ramulator {
 
+/**
+ * @brief    Evaluates the prerequisite command and readiness of the requests in a buffer
+ * @details
+ * The device state that decides both only lives at the levels above the row, so every request to the same row of
+ * the same bank with the same final command gets the same answer within a cycle. Results are grouped by bank, keyed
+ * by the flat bank id of BankMap, and reused until the next clear(). Prerequisite commands are also cached in the
+ * requests across cycles, and only recomputed once the DRAM publishes a new state epoch for their banks.
+ * 
+ */
+class BankReadiness {
+private:
+    struct BankEntry {
+        int final_command;
+        Addr_t row;
+        int command;
+        bool ready;
+    };
+
+    IDRAM *m_dram = nullptr;
+    BankMap m_bank_map;
+    int m_row_addr_idx = -1;
+    std::vector<std::vector<BankEntry>> m_bank_entries; // [flat bank id]: Results evaluated since the last clear()
+    std::vector<int> m_touched_banks;                   // Banks with entries to clear at the next clear()
+
+public:
+    void setup(IDRAM *dram) {
+        m_dram = dram;
+        m_bank_map.setup(m_dram);
+        m_row_addr_idx = m_bank_map.get_row_addr_idx();
+        m_bank_entries.resize(m_bank_map.get_num_banks());
+    };
+
+    int get_num_banks() const { return m_bank_entries.size(); };
+
+    void clear() {
+        for (int bank_id : m_touched_banks) {
+            m_bank_entries[bank_id].clear();
+        }
+        m_touched_banks.clear();
+    };
+
+    /**
+     * @brief    Sets the prerequisite command of the request and returns whether it is ready
+     * 
+     */
+    bool evaluate(Request &req) {
+        int bank_id = get_flat_bank_id(req.addr_vec);
+        if (bank_id < 0) {
+            // Not a single bank: nothing to share with other requests
+            req.command = m_dram->get_preq_command(req);
+            return m_dram->check_ready(req.command, req.addr_vec);
+        }
+
+        auto &entries = m_bank_entries[bank_id];
+        Addr_t row = req.addr_vec[m_row_addr_idx];
+        for (const auto &entry : entries) {
+            if (entry.final_command == req.final_command && entry.row == row) {
+                req.command = entry.command;
+                return entry.ready;
+            }
+        }
+
+        if (entries.empty()) {
+            m_touched_banks.push_back(bank_id);
+        }
+        req.command = m_dram->get_preq_command(req);
+        bool ready = m_dram->check_ready(req.command, req.addr_vec);
+        entries.push_back({req.final_command, row, req.command, ready});
+        return ready;
+    };
+
+    int get_flat_bank_id(const AddrVec_t &addr_vec) const { return m_bank_map.get_flat_bank_id(addr_vec); };
+};
+
+/**
+ * @brief    Folds the oldest ready request, or the oldest request if none is ready, in one pass over the buffer
+ * 
+ */
+static ReqBuffer::iterator get_first_ready_request(ReqBuffer &buffer, BankReadiness &readiness) {
+    if (buffer.size() == 0) {
+        return buffer.end();
+    }
+
+    readiness.clear();
+    auto oldest = buffer.end();
+    auto oldest_ready = buffer.end();
+    for (auto it = buffer.begin(); it != buffer.end(); it++) {
+        bool ready = readiness.evaluate(*it);
+        if (oldest == buffer.end() || it->arrive < oldest->arrive) {
+            oldest = it;
+        }
+        if (ready && (oldest_ready == buffer.end() || it->arrive < oldest_ready->arrive)) {
+            oldest_ready = it;
+        }
+    }
+    return (oldest_ready != buffer.end()) ? oldest_ready : oldest;
+}
+
 class FRFCFS : public IScheduler, public Implementation {
     RAMULATOR_REGISTER_IMPLEMENTATION(IScheduler, FRFCFS, "FRFCFS", "FRFCFS DRAM Scheduler.")
 private:
     IDRAM *m_dram;
+    BankReadiness m_readiness;
 
 public:
     void init() override{};
 
     void setup(IFrontEnd *frontend, IMemorySystem *memory_system) override {
         m_dram = cast_parent<IDRAMController>()->m_dram;
+        m_readiness.setup(m_dram);
     };
 
     ReqBuffer::iterator compare(ReqBuffer::iterator req1, ReqBuffer::iterator req2) override {
@@ -39,19 +141,181 @@ public:
     }
 
     ReqBuffer::iterator get_best_request(ReqBuffer &buffer) override {
-        if (buffer.size() == 0) {
-            return buffer.end();
+        // Same choice as folding compare() over the buffer, but every request is evaluated once
+        return get_first_ready_request(buffer, m_readiness);
+    }
+};
+
+/**
+ * @brief    FRFCFS scheduler that also serves AiM requests out of order
+ * @details
+ * An AiM request may bypass older AiM requests of its channel if it is ready and does not conflict with any of them:
+ * it targets none of their banks (which also orders the MAC accumulators of a bank), it does not read the global
+ * buffer an older request writes (or write the one an older request uses), and no TMOD switch lies between them.
+ * SYNC and EOC requests are never bypassed. This lets e.g. single-bank MACs or copies to idle banks overlap with the
+ * row activation of an older request.
+ * 
+ * With group_reg_RW_mode, requests of the current register mode of the channel may also bypass older requests of the
+ * other mode, and are waited for before the mode is switched. This groups e.g. independent WR_GB, WR_BIAS, RD_MAC,
+ * and RD_AF requests so that fewer TMODs (and their nMODCH) are needed.
+ * 
+ */
+class AiMFRFCFS : public IScheduler, public Implementation {
+    RAMULATOR_REGISTER_IMPLEMENTATION(IScheduler, AiMFRFCFS, "AiMFRFCFS", "FRFCFS DRAM Scheduler with out-of-order AiM requests.")
+private:
+    /**
+     * @brief    The resources that an AiM opcode uses besides its banks
+     * 
+     */
+    struct AiMFootprint {
+        bool uses_banks = true;
+        bool reads_GB = false;
+        bool writes_GB = false;
+        bool requires_reg_RW_mode = false;
+    };
+
+    IDRAM *m_dram;
+    BankReadiness m_readiness;
+    std::vector<AiMFootprint> m_footprints; // [opcode]
+    int m_window = -1;
+    bool m_group_reg_RW_mode = false;
+
+    size_t s_num_mode_grouped_requests = 0;
+
+public:
+    void init() override {
+        m_window = param<int>("window").desc("Number of the oldest AiM requests considered for out-of-order issue.").default_val(16);
+        if (m_window < 1) {
+            throw ConfigurationError("AiMFRFCFS: window ({}) must be positive!", m_window);
         }
+        m_group_reg_RW_mode = param<bool>("group_reg_RW_mode").desc("Serve AiM requests of the current register mode first to save TMOD switches.").default_val(false);
+    };
 
-        for (auto &req : buffer) {
-            req.command = m_dram->get_preq_command(req.final_command, req.addr_vec);
+    void setup(IFrontEnd *frontend, IMemorySystem *memory_system) override {
+        m_dram = cast_parent<IDRAMController>()->m_dram;
+        m_readiness.setup(m_dram);
+        if (m_readiness.get_num_banks() > 64) {
+            throw ConfigurationError("AiMFRFCFS: at most 64 banks per channel are supported, {} has {}!", m_dram->get_name(), m_readiness.get_num_banks());
         }
 
-        auto candidate = buffer.begin();
-        for (auto next = std::next(buffer.begin(), 1); next != buffer.end(); next++) {
-            candidate = compare(candidate, next);
+        m_footprints.resize((int)Opcode::MAX);
+        for (int opcode = (int)Opcode::MIN + 1; opcode < (int)Opcode::MAX; opcode++) {
+            auto &footprint = m_footprints[opcode];
+            footprint.requires_reg_RW_mode = AiMISRInfo::opcode_requires_reg_RW_mod((Opcode)opcode);
+            switch ((Opcode)opcode) {
+            case Opcode::ISR_WR_GB: {
+                footprint.uses_banks = false;
+                footprint.writes_GB = true;
+                break;
+            }
+            case Opcode::ISR_COPY_BKGB: {
+                footprint.writes_GB = true;
+                break;
+            }
+            case Opcode::ISR_COPY_GBBK:
+            case Opcode::ISR_MAC_SBK:
+            case Opcode::ISR_MAC_ABK: {
+                footprint.reads_GB = true;
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        register_stat(s_num_mode_grouped_requests)
+            .name(fmt::format("CH{}_num_mode_grouped_AiM_requests", cast_parent<IDRAMController>()->m_channel_id))
+            .desc("total number of AiM requests served before an older request of the other register mode");
+    };
+
+    ReqBuffer::iterator compare(ReqBuffer::iterator req1, ReqBuffer::iterator req2) override {
+        bool ready1 = m_dram->check_ready(req1->command, req1->addr_vec);
+        bool ready2 = m_dram->check_ready(req2->command, req2->addr_vec);
+
+        if (ready1 ^ ready2) {
+            if (ready1) {
+                return req1;
+            } else {
+                return req2;
+            }
+        }
+
+        // Fallback to FCFS
+        if (req1->arrive <= req2->arrive) {
+            return req1;
+        } else {
+            return req2;
+        }
+    }
+
+    ReqBuffer::iterator get_best_request(ReqBuffer &buffer) override {
+        return get_first_ready_request(buffer, m_readiness);
+    }
+
+    ReqBuffer::iterator get_best_AiM_request(ReqBuffer &buffer, bool is_reg_RW_mode) override {
+        auto head = buffer.begin();
+        if ((head == buffer.end()) || is_barrier(*head)) {
+            return head;
+        }
+
+        m_readiness.clear();
+        bool is_head_switching = (m_footprints[(int)head->opcode].requires_reg_RW_mode != is_reg_RW_mode);
+        bool requires_reg_RW_mode = m_group_reg_RW_mode ? is_reg_RW_mode : m_footprints[(int)head->opcode].requires_reg_RW_mode;
+        uint64_t older_banks = 0;
+        bool older_reads_GB = false;
+        bool older_writes_GB = false;
+        auto first_waiting = buffer.end();
+
+        // The oldest ready request without a hazard on the older ones; the head has none
+        int num_scanned = 0;
+        for (auto it = head; (it != buffer.end()) && (num_scanned < m_window); it++, num_scanned++) {
+            if (is_barrier(*it)) {
+                break;
+            }
+            const auto &footprint = m_footprints[(int)it->opcode];
+            bool is_other_mode = (footprint.requires_reg_RW_mode != requires_reg_RW_mode);
+            if (is_other_mode && !m_group_reg_RW_mode) {
+                // Reordering across a TMOD switch would toggle the mode back and forth
+                break;
+            }
+
+            uint64_t banks = get_bank_mask(*it, footprint);
+            bool has_hazard = ((banks & older_banks) != 0) ||
+                              (footprint.reads_GB && older_writes_GB) ||
+                              (footprint.writes_GB && (older_reads_GB || older_writes_GB));
+            if (!has_hazard && !is_other_mode) {
+                if (m_readiness.evaluate(*it)) {
+                    s_num_mode_grouped_requests += (m_group_reg_RW_mode && is_head_switching && (it->issue == -1));
+                    return it;
+                }
+                if (first_waiting == buffer.end()) {
+                    first_waiting = it;
+                }
+            }
+
+            older_banks |= banks;
+            older_reads_GB |= footprint.reads_GB;
+            older_writes_GB |= footprint.writes_GB;
+        }
+
+        if (m_group_reg_RW_mode && is_head_switching && (first_waiting != buffer.end())) {
+            // Wait for a request of the current mode rather than switching the mode now and back later
+            return first_waiting;
+        }
+        return head;
+    }
+
+private:
+    static bool is_barrier(const Request &req) {
+        return (req.opcode == Opcode::ISR_EOC) || (req.opcode == Opcode::ISR_SYNC);
+    }
+
+    uint64_t get_bank_mask(const Request &req, const AiMFootprint &footprint) const {
+        if (!footprint.uses_banks) {
+            return 0;
         }
-        return candidate;
+        int bank_id = m_readiness.get_flat_bank_id(req.addr_vec);
+        return (bank_id < 0) ? ~(uint64_t)0 : ((uint64_t)1 << bank_id);
     }
 };
 
@@ -14,6 +14,18 @@ class IRefreshManager {
 
   public:
     virtual void tick() = 0;
+
+    /**
+     * @brief    Returns how many upcoming ticks are guaranteed to not send any refresh request.
+     * 
+     */
+    virtual Clk_t get_skippable_cycles() { return 0; };
+
+    /**
+     * @brief    Advances the refresh manager by num_cycles without ticking it.
+     * 
+     */
+    virtual void skip_cycles(Clk_t num_cycles) {};
 };
 
 }        // namespace Ramulator
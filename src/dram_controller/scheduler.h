@@ -16,6 +16,16 @@ class IScheduler {
     virtual ReqBuffer::iterator compare(ReqBuffer::iterator req1, ReqBuffer::iterator req2) = 0;
 
     virtual ReqBuffer::iterator get_best_request(ReqBuffer& buffer) = 0;
+
+    /**
+     * @brief    Returns the AiM request to serve next
+     * @details
+     * AiM requests have data hazards that the generic schedulers do not track, so they are served in order by
+     * default. AiM-aware schedulers may return a younger request whose hazards with the older ones are satisfied.
+     * is_reg_RW_mode is the current mode of the channel, which a request of the other mode has to switch with TMOD.
+     * 
+     */
+    virtual ReqBuffer::iterator get_best_AiM_request(ReqBuffer& buffer, bool is_reg_RW_mode) { return buffer.begin(); };
 };
 
 }       // namespace Ramulator
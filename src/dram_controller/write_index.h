@@ -0,0 +1,48 @@
+#ifndef RAMULATOR_CONTROLLER_WRITE_INDEX_H
+#define RAMULATOR_CONTROLLER_WRITE_INDEX_H
+
+#include <functional>
+#include <unordered_map>
+
+#include "base/base.h"
+
+namespace Ramulator {
+
+struct AddrVecHash {
+    size_t operator()(const AddrVec_t &addr_vec) const {
+        size_t hash = addr_vec.size();
+        for (int addr : addr_vec) {
+            hash ^= std::hash<int>()(addr) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    };
+};
+
+/**
+ * @brief    Counts the in-flight writes of a controller per address
+ * @details
+ * The controller adds a write when it is buffered and removes it once it has completed, so an incoming read can be
+ * checked for forwarding with one lookup, wherever the write currently is (write buffer, active buffer, or pending).
+ * 
+ */
+template <typename Key_t, typename Hash_t = std::hash<Key_t>>
+class WriteIndex {
+private:
+    std::unordered_map<Key_t, int, Hash_t> m_num_writes; // [address]: In-flight writes to the address
+
+public:
+    void add(const Key_t &key) { m_num_writes[key]++; };
+
+    void remove(const Key_t &key) {
+        auto it = m_num_writes.find(key);
+        if (--it->second == 0) {
+            m_num_writes.erase(it);
+        }
+    };
+
+    bool contains(const Key_t &key) const { return m_num_writes.find(key) != m_num_writes.end(); };
+};
+
+} // namespace Ramulator
+
+#endif // RAMULATOR_CONTROLLER_WRITE_INDEX_H
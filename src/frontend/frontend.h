@@ -33,6 +33,12 @@ public:
 
     virtual bool is_finished() = 0;
 
+    /**
+     * @brief    Whether ticking the frontend is a no-op (e.g., everything has already been sent)
+     * 
+     */
+    virtual bool is_idle() { return false; };
+
     virtual void finalize() {
         for (auto component : m_components) {
             component->finalize();
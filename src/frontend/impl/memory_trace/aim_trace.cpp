@@ -4,7 +4,9 @@
 #include <fstream>
 #include <ios>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "base/exception.h"
@@ -101,7 +103,9 @@ private:
 
     template <typename T>
     T token_decoder(std::string str) {
-        if (str.compare(0, 2, "0x") == 0 | str.compare(0, 2, "0X") == 0) {
+        if constexpr (std::is_same_v<T, ChannelMask>) {
+            return ChannelMask::from_str(str);
+        } else if (str.compare(0, 2, "0x") == 0 | str.compare(0, 2, "0X") == 0) {
             return std::stoll(str.substr(2), nullptr, 16);
         } else {
             return std::stoll(str);
@@ -152,8 +156,9 @@ private:
                     continue;
                 } else {
                     req.host_req_id = host_req_id++;
+                    AiMISRPayload payload;
 
-                    int token_idx = 0;
+                    size_t token_idx = 0;
 
                     // printf("#%d:", m_curr_trace_idx);
                     // for (auto token : tokens) {
@@ -174,7 +179,9 @@ private:
                             ISR_opcode = prefix + ISR_opcode;
                         AiMISR aim_request = AiMISRInfo::convert_opcode_str_to_AiM_ISR(ISR_opcode);
 
-                        if (aim_request.legal_fields.size() != tokens.size() - 2) {
+                        // The fields may be followed by the device id
+                        bool has_device_id = (aim_request.legal_fields.size() + 1 == tokens.size() - 2);
+                        if ((aim_request.legal_fields.size() != tokens.size() - 2) && !has_device_id) {
                             throw ConfigurationError("Trace: aim request {} requires {} fields, but {} is specified in line: \n{}!",
                                                      AiMISRInfo::convert_AiM_opcode_to_str(aim_request.opcode),
                                                      aim_request.legal_fields.size(),
@@ -185,12 +192,12 @@ private:
                         req.opcode = aim_request.opcode;
 
                         // Decoding other fields
-#define DECODE_AND_SET_FIELD(name) \
-    req.name = token_decoder<decltype(req.name)>(tokens[token_idx++]);
+#define DECODE_AND_SET_FIELD(dst, name) \
+    dst.name = token_decoder<decltype(dst.name)>(tokens[token_idx++]);
 
 #define DECODE_AIM_HOST_REQ_FIELD(name) \
-    DECODE_AND_SET_FIELD(name)          \
-    aim_request.is_field_value_legal<decltype(req.name)>(AiMISR::Field::name, req.name);
+    DECODE_AND_SET_FIELD(payload, name) \
+    aim_request.is_field_value_legal<decltype(payload.name)>(AiMISR::Field::name, payload.name);
 
 #define DECODE_AIM_HOST_REQ_FIELD_IF_NEEDED(name)          \
     if (aim_request.is_field_legal(AiMISR::Field::name)) { \
@@ -205,6 +212,10 @@ private:
                         DECODE_AIM_HOST_REQ_FIELD_IF_NEEDED(row_addr)
                         DECODE_AIM_HOST_REQ_FIELD_IF_NEEDED(col_addr)
                         DECODE_AIM_HOST_REQ_FIELD_IF_NEEDED(thread_index)
+                        if (has_device_id) {
+                            DECODE_AND_SET_FIELD(payload, device_id)
+                        }
+                        req.payload = std::make_shared<const AiMISRPayload>(payload);
 
                         if (req.opcode == Opcode::ISR_EOC) {
                             m_trace_reached_EOC = true;
@@ -216,15 +227,35 @@ private:
                         // Decoding opcode
                         req.mem_access_region = AiMISRInfo::convert_str_to_mem_access_region(tokens[token_idx++]);
 
+                        // The fields may be followed by the device id
+                        size_t num_fields = (req.mem_access_region == MemAccessRegion::CFR)   ? 2
+                                            : (req.mem_access_region == MemAccessRegion::GPR) ? 1
+                                                                                              : 3;
+                        bool has_device_id = (num_fields + 1 == tokens.size() - token_idx);
+                        if ((num_fields != tokens.size() - token_idx) && !has_device_id) {
+                            throw ConfigurationError("Trace: {} request to {} requires {} fields, but {} is specified in line: \n{}!",
+                                                     AiMISRInfo::convert_type_to_str(req.type),
+                                                     tokens[token_idx - 1],
+                                                     num_fields,
+                                                     tokens.size() - token_idx,
+                                                     line);
+                        }
+
                         if (req.mem_access_region == MemAccessRegion::CFR) {
-                            DECODE_AND_SET_FIELD(addr)
-                            DECODE_AND_SET_FIELD(data)
+                            DECODE_AND_SET_FIELD(req, addr)
+                            DECODE_AND_SET_FIELD(req, data)
                         } else if (req.mem_access_region == MemAccessRegion::GPR) {
-                            DECODE_AND_SET_FIELD(addr)
+                            DECODE_AND_SET_FIELD(req, addr)
                         } else {
-                            DECODE_AND_SET_FIELD(channel_mask)
-                            DECODE_AND_SET_FIELD(bank_index)
-                            DECODE_AND_SET_FIELD(row_addr)
+                            DECODE_AND_SET_FIELD(payload, channel_id)
+                            DECODE_AND_SET_FIELD(payload, bank_index)
+                            DECODE_AND_SET_FIELD(payload, row_addr)
+                        }
+                        if (has_device_id) {
+                            DECODE_AND_SET_FIELD(payload, device_id)
+                        }
+                        if ((req.mem_access_region == MemAccessRegion::MEM) || (payload.device_id != -1)) {
+                            req.payload = std::make_shared<const AiMISRPayload>(payload);
                         }
                     }
                 }
@@ -236,6 +267,8 @@ private:
 
     // TODO: FIXME
     bool is_finished() override { return m_trace_reached_calledback; };
+
+    bool is_idle() override { return m_trace_reached_EOC && !remaining_req; };
 };
 
-} // namespace Ramulator
\ No newline at end of file
+} // namespace Ramulator
\ No newline at end of file
@@ -125,6 +125,14 @@ int main(int argc, char *argv[]) {
         if ((i % tick_mult) % frontend_tick == 0) {
             memory_system->tick();
         }
+
+        // Jump over the cycles in which nothing can happen (only when every component ticks every cycle)
+        if ((tick_mult == 1) && frontend->is_idle()) {
+            if (Ramulator::Clk_t skippable_cycles = memory_system->get_skippable_cycles(); skippable_cycles > 0) {
+                memory_system->skip_cycles(skippable_cycles);
+                i += skippable_cycles;
+            }
+        }
     }
 
     // Finalize the simulation. Recursively print all statistics from all components
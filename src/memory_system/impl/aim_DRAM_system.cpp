@@ -5,16 +5,21 @@
 #include "dram_controller/controller.h"
 #include "memory_system/memory_system.h"
 #include "translation/translation.h"
+#include <algorithm>
+#include <barrier>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
+#include <deque>
+#include <limits>
 #include <math.h>
+#include <memory>
+#include <thread>
 #include <vector>
 
 namespace Ramulator {
 
 #define ISR_SIZE (1 << 21)
-#define MAX_CHANNEL_COUNT 32
 
 class AiMDRAMSystem final : public IMemorySystem, public Implementation {
     RAMULATOR_REGISTER_IMPLEMENTATION(IMemorySystem, AiMDRAMSystem, "AiMDRAM", "AiM memory system (AiM DMA).");
@@ -26,74 +31,381 @@ protected:
     bool m_has_rank = false; // Does the DRAM have rank level?
     IAddrMapper *m_addr_mapper;
     std::vector<IDRAMController *> m_controllers;
+    int m_num_devices = 1;         // AiM devices, each owning a contiguous block of m_num_device_channels channels
+    int m_num_device_channels = -1;
+    int m_channel_mask_width = -1; // Bits of a channel mask that select the channels of a device
     Logger_t m_logger;
     std::queue<Request> request_queue;
-    std::queue<Request> remaining_AiM_requests[MAX_CHANNEL_COUNT];
     int AiM_req_id = 0;
 
-    int stalled_AiM_requests = 0;
+    /**
+     * @brief    A range of GPRs [begin, end), in 256-bit GPRs
+     * 
+     */
+    struct GPRRange {
+        int device_id = -1; // Every device has its own GPRs
+        Addr_t begin = 0;
+        Addr_t end = 0;
 
-    std::function<void(Request &)> callback;
+        bool overlaps(const GPRRange &other) const { return (device_id == other.device_id) && (begin < other.end) && (other.begin < end); };
+    };
+
+    /**
+     * @brief    The GPRs that a host request reads its operands from and writes its results to
+     * 
+     */
+    struct GPRFootprint {
+        GPRRange reads[2];
+        GPRRange write;
+    };
+
+    enum class GPRHazard {
+        NONE,
+        RAW, // Reads a GPR that an older host request has not written yet
+        WAR, // Writes a GPR that an older host request has not read yet
+        WAW  // Writes a GPR that an older host request has not written yet
+    };
+
+    /**
+     * @brief    A decoded host request whose per-channel requests are being handed out or waited for
+     * @details
+     * A host request with opsize N over C channels stands for N * C per-channel requests. They are built one at a time
+     * from this descriptor when their controller has room, so the DMA never holds more than one of them. Channel
+     * channel_ids[i] receives the columns base_col_addr, base_col_addr + 1, ... in order.
+     * 
+     */
+    struct ISRExpansion {
+        Request host_req{0, -1};
+        Request aim_req{0, -1};       // Template of the per-channel requests; its address and callback are set per request
+        std::vector<int> channel_ids; // Channels that receive the requests
+        std::vector<int> num_sent;    // [i]: Requests handed out to channel_ids[i]
+        int bank_index = -1;
+        int row_addr = -1;
+        int base_col_addr = -1;
+        int opsize = 0;
+        bool is_blocking = false;     // Does the host request hold back the decoding of the younger ones?
+        bool waits_for_completion = false; // Is the host request done only once its per-channel requests complete?
+        GPRFootprint GPR_footprint;
+        int num_remaining = 0;        // Requests not handed out yet
+        int num_pending = 0;          // Requests handed out and not completed yet, if waits_for_completion
+
+        bool is_done() const { return (num_remaining == 0) && (num_pending == 0); };
+    };
+
+    /**
+     * @brief    The per-channel requests of a host request still to be handed out to one channel
+     * 
+     */
+    struct ChannelSlot {
+        ISRExpansion *expansion;
+        int index; // Index of the channel in expansion->channel_ids
+    };
+
+    // Decoded host requests in program order. A host request is completed (and its callback called) once it and all
+    // the older ones are done, so that the frontend sees them complete in order
+    std::deque<ISRExpansion> m_expansions;
+    std::vector<std::deque<ChannelSlot>> m_channel_queues; // [channel]: Host requests to hand out to it, oldest first
+    int m_decode_window = 1;            // Host requests the DMA can have decoded and not completed
+    int m_num_blocking_expansions = 0;  // Blocking host requests in m_expansions
+    bool m_use_GPR_scoreboard = false;  // Do reads into the GPRs rely on the scoreboard instead of blocking?
+    int m_num_unsent_requests = 0;      // Per-channel requests of m_expansions not handed out yet
+    int m_issue_width = 0;              // Per-channel requests the DMA can hand out per cycle (0: unlimited)
+    int m_num_issued = 0;               // Per-channel requests handed out in this cycle
+    int m_next_channel = 0;             // Channel to offer the first request to in the next cycle
+    std::vector<int> m_expanding_channels; // Scratch of expand(), kept to avoid an allocation per cycle
+
+    bool m_skip_ahead = false;
+    bool m_is_DMA_active = true; // Did the DMA decode or send anything in the last tick?
+
+    std::vector<std::function<void(Request &)>> m_channel_callbacks; // Completion callback of the AiM requests sent to each channel
+
+    int m_num_threads = 1;
+    std::vector<std::thread> m_workers;              // Worker threads, each ticking the controllers of one slice of the channels
+    std::unique_ptr<std::barrier<>> m_tick_barrier;  // Synchronizes the workers with the DMA around every controller tick
+    bool m_is_stopping = false;                      // Tells the workers to exit at the next barrier
+    std::vector<std::vector<Request>> m_completions; // Completions received by each channel during a parallel controller tick
 
     enum class CFR {
         BROADCAST,
         EWMUL_BG,
         AFM
     };
-    std::map<CFR, int32_t> CFR_values;
+    std::vector<std::map<CFR, int32_t>> CFR_values; // [device]
     std::map<Addr_t, CFR> address_to_CFR;
 
-    uint8_t CountSetBit(const int64_t ch_mask) const {
-        assert(ch_mask > 0);
+    int get_device_id(const Request &host_req) const {
+        int device_id = host_req.isr().device_id;
+        if (device_id == -1) {
+            return 0;
+        }
+        if ((device_id < 0) || (device_id >= m_num_devices)) {
+            throw ConfigurationError("AiMDRAMSystem: {} targets device {}, but there are only {} devices!", host_req.str(), device_id, m_num_devices);
+        }
+        return device_id;
+    }
 
-        uint8_t count = 0;
+    int get_MEM_channel_id(const Request &host_req) const {
+        int channel_id = host_req.isr().channel_id;
+        if ((channel_id < 0) || (channel_id >= m_num_device_channels)) {
+            throw ConfigurationError("AiMDRAMSystem: {} targets channel {}, but a device has only {} channels!", host_req.str(), channel_id, m_num_device_channels);
+        }
+        return get_device_id(host_req) * m_num_device_channels + channel_id;
+    }
 
-        for (int i = 0; i < MAX_CHANNEL_COUNT; i++)
-            if (ch_mask & (0x1 << i))
-                count++;
+    /**
+     * @brief    Appends the channels selected by the channel mask of host_req to channel_ids, from the least
+     *           significant bit of the mask
+     * 
+     */
+    void add_masked_channels(const Request &host_req, std::vector<int> &channel_ids) const {
+        int first_channel_id = get_device_id(host_req) * m_num_device_channels;
+        host_req.isr().channel_mask.for_each_bit([&](int bit) {
+            int channel_id = m_channel_mask_width - 1 - bit;
+            if ((channel_id < 0) || (channel_id >= m_num_device_channels)) {
+                throw ConfigurationError("AiMDRAMSystem: channel mask {} of {} selects a channel beyond the {} channels of a device!",
+                                         host_req.isr().channel_mask.str(), host_req.str(), m_num_device_channels);
+            }
+            channel_ids.push_back(first_channel_id + channel_id);
+        });
+    }
 
-        return count;
+    void start_expansion(ISRExpansion &expansion, const Request &aim_req, int bank_index, int row_addr, int base_col_addr, int opsize, bool waits_for_completion) {
+        // The caller has filled expansion.channel_ids
+        expansion.aim_req = aim_req;
+        expansion.num_sent.assign(expansion.channel_ids.size(), 0);
+        expansion.bank_index = bank_index;
+        expansion.row_addr = row_addr;
+        expansion.base_col_addr = base_col_addr;
+        expansion.opsize = opsize;
+        expansion.waits_for_completion = waits_for_completion;
+        expansion.num_remaining = opsize * expansion.channel_ids.size();
+        m_num_unsent_requests += expansion.num_remaining;
+
+        if (opsize > 0) {
+            for (int i = 0; i < expansion.channel_ids.size(); i++) {
+                int channel_id = expansion.channel_ids[i];
+                if ((channel_id < 0) || (channel_id >= m_controllers.size())) {
+                    throw ConfigurationError("AiMDRAMSystem: {} targets channel {}, but there are only {} channels!", expansion.host_req.str(), channel_id, m_controllers.size());
+                }
+                m_channel_queues[channel_id].push_back({&expansion, i});
+            }
+        }
     }
 
-    uint8_t FindFirstChannelIndex(int64_t &ch_mask) const {
-        uint32_t ch_mask_u = ch_mask;
-        assert(ch_mask_u & 0xffffffff != 0);
+    /**
+     * @brief    Hands out the next per-channel requests of the decoded host requests, and returns whether any was sent
+     * @details
+     * Channels are offered one request at a time in round-robin order, which matches the column-major order of an
+     * ISR, until the issue width is used up or every channel has refused a request or has nothing left. Each channel
+     * takes the requests of its oldest host request first, so the channels stay in program order individually but do
+     * not wait for each other.
+     * 
+     */
+    bool expand() {
+        int num_channels = m_controllers.size();
+        int num_issued = m_num_issued;
+
+        auto &channels = m_expanding_channels;
+        channels.clear();
+        for (int i = 0; i < num_channels; i++) {
+            int channel_id = (m_next_channel + i) % num_channels;
+            if (m_channel_queues[channel_id].empty() == false) {
+                channels.push_back(channel_id);
+            }
+        }
 
-        for (int i = 0; i < MAX_CHANNEL_COUNT; i++) {
-            if (ch_mask_u & (0x1 << i)) {
-                ch_mask_u &= ~(0x1 << i);
-                ch_mask = ch_mask_u;
-                return MAX_CHANNEL_COUNT - 1 - i;
+        while (channels.empty() == false) {
+            int num_kept = 0;
+            for (int i = 0; i < channels.size(); i++) {
+                int channel_id = channels[i];
+                if ((m_issue_width != 0) && (m_num_issued == m_issue_width)) {
+                    channels[num_kept++] = channel_id;
+                    continue;
+                }
+                m_next_channel = (channel_id + 1) % num_channels;
+                if (send_next_request(channel_id) && (m_channel_queues[channel_id].empty() == false)) {
+                    channels[num_kept++] = channel_id;
+                }
             }
+            channels.resize(num_kept);
+            if ((m_issue_width != 0) && (m_num_issued == m_issue_width)) {
+                break;
+            }
+        }
+
+        return m_num_issued > num_issued;
+    }
+
+    bool send_next_request(int channel_id) {
+        auto &queue = m_channel_queues[channel_id];
+        ISRExpansion &expansion = *queue.front().expansion;
+        int i = queue.front().index;
+
+        Request &aim_req = expansion.aim_req;
+        apply_addr_mapp(aim_req, channel_id, expansion.bank_index, expansion.row_addr, expansion.base_col_addr + expansion.num_sent[i]);
+        if (expansion.waits_for_completion) {
+            aim_req.callback = m_channel_callbacks[channel_id];
+        }
+        aim_req.AiM_req_id = AiM_req_id;
+        // m_logger->info("[CLK {}] Sending {} to channel {}", m_clk, aim_req.str(), channel_id);
+        if (m_controllers[channel_id]->send(aim_req) == false) {
+            return false;
         }
 
-        assert(false);
-        return 0;
+        AiM_req_id++;
+        if (expansion.waits_for_completion) {
+            expansion.num_pending++;
+        }
+        m_num_issued++;
+        m_num_unsent_requests--;
+        expansion.num_remaining--;
+        if (++expansion.num_sent[i] == expansion.opsize) {
+            queue.pop_front();
+        }
+        return true;
     }
 
-    void apply_addr_mapp(Request &req, int channel_id) {
+    /**
+     * @brief    Returns whether the next host request can be decoded in this cycle
+     * @details
+     * Blocking host requests (SYNC, EOC, and, without the GPR scoreboard, reads into the GPRs) hold back all the
+     * younger ones. Otherwise a host request only waits for the GPR hazards on the in-flight ones.
+     * 
+     */
+    bool can_decode() const {
+        return (request_queue.empty() == false) && (m_expansions.size() < m_decode_window) &&
+               !is_decode_stalled_by_blocking() && (get_GPR_hazard(get_GPR_footprint(request_queue.front())) == GPRHazard::NONE);
+    }
+
+    bool is_decode_stalled_by_blocking() const { return m_num_blocking_expansions != 0; }
+
+    /**
+     * @brief    Returns the GPRs that host_req reads and writes
+     * @details
+     * GPR addresses count 256-bit GPRs. Writes from the GPRs to the banks and the global buffer take opsize GPRs, the
+     * same for every channel, while reads into the GPRs take one result per channel.
+     * 
+     */
+    GPRFootprint get_GPR_footprint(const Request &host_req) const {
+        GPRFootprint footprint;
+        int device_id = get_device_id(host_req);
+        switch (host_req.type) {
+        case Type::AIM: {
+            const AiMISRPayload &isr = host_req.isr();
+            if (isr.GPR_addr_0 == -1) {
+                break;
+            }
+            int opsize = (isr.opsize == -1) ? 1 : isr.opsize;
+            switch (host_req.opcode) {
+            case Opcode::ISR_WR_SBK:
+            case Opcode::ISR_WR_ABK:
+            case Opcode::ISR_WR_GB:
+            case Opcode::ISR_WR_BIAS: {
+                footprint.reads[0] = {device_id, isr.GPR_addr_0, isr.GPR_addr_0 + opsize};
+                break;
+            }
+            case Opcode::ISR_RD_MAC:
+            case Opcode::ISR_RD_AF: {
+                // ISR_RD_SBK is not blocking and returns its data to the host, so it is not tracked either
+                footprint.write = {device_id, isr.GPR_addr_0, isr.GPR_addr_0 + isr.channel_mask.count()};
+                break;
+            }
+            case Opcode::ISR_EWADD: {
+                footprint.reads[0] = {device_id, isr.GPR_addr_0, isr.GPR_addr_0 + opsize};
+                if (isr.GPR_addr_1 != -1) {
+                    footprint.reads[1] = {device_id, isr.GPR_addr_1, isr.GPR_addr_1 + opsize};
+                }
+                footprint.write = footprint.reads[0];
+                break;
+            }
+            default:
+                break;
+            }
+            break;
+        }
+        case Type::Read:
+        case Type::Write: {
+            if (host_req.mem_access_region == MemAccessRegion::GPR) {
+                GPRRange range = {device_id, host_req.addr, host_req.addr + 1};
+                if (host_req.type == Type::Read) {
+                    footprint.reads[0] = range;
+                } else {
+                    footprint.write = range;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        return footprint;
+    }
+
+    /**
+     * @brief    Returns the first hazard of a host request with the given footprint on the in-flight host requests
+     * @details
+     * The operands of an in-flight host request are read from the GPRs as its per-channel requests are handed out,
+     * and its results are written to them as its per-channel requests complete.
+     * 
+     */
+    GPRHazard get_GPR_hazard(const GPRFootprint &footprint) const {
+        for (const auto &expansion : m_expansions) {
+            if (expansion.is_done()) {
+                continue;
+            }
+            const GPRFootprint &older = expansion.GPR_footprint;
+            for (const auto &read : footprint.reads) {
+                if (read.overlaps(older.write)) {
+                    return GPRHazard::RAW;
+                }
+            }
+            if (expansion.num_remaining != 0) {
+                for (const auto &older_read : older.reads) {
+                    if (footprint.write.overlaps(older_read)) {
+                        return GPRHazard::WAR;
+                    }
+                }
+            }
+            if (footprint.write.overlaps(older.write)) {
+                return GPRHazard::WAW;
+            }
+        }
+        return GPRHazard::NONE;
+    }
+
+    void retire_completed() {
+        while ((m_expansions.empty() == false) && m_expansions.front().is_done()) {
+            Request host_req = m_expansions.front().host_req;
+            m_num_blocking_expansions -= m_expansions.front().is_blocking;
+            m_expansions.pop_front();
+            if (host_req.callback)
+                host_req.callback(host_req);
+        }
+    }
+
+    void apply_addr_mapp(Request &req, int channel_id, int bank_index, int row_addr, int col_addr) {
         req.addr_vec.resize(m_num_levels, -1);
-        if ((channel_id < 0) || (channel_id >= MAX_CHANNEL_COUNT)) {
-            m_logger->error("{} has CH more than {}!", req.str(), MAX_CHANNEL_COUNT);
+        if ((channel_id < 0) || (channel_id >= m_controllers.size())) {
+            m_logger->error("{} has CH more than {}!", req.str(), m_controllers.size());
             exit(-1);
         }
         req.addr_vec[m_dram->m_levels("channel")] = channel_id;
         if (m_has_rank) {
             req.addr_vec[m_dram->m_levels("rank")] = 0;
         }
-        if (req.bank_index == -1) {
+        if (bank_index == -1) {
             req.addr_vec[m_dram->m_levels("bankgroup")] = -1;
             req.addr_vec[m_dram->m_levels("bank")] = -1;
         } else {
-            if ((req.bank_index < 0) || (req.bank_index >= 16)) {
+            if ((bank_index < 0) || (bank_index >= 16)) {
                 m_logger->error("{} has BA more than 16!", req.str());
                 exit(-1);
             }
-            req.addr_vec[m_dram->m_levels("bankgroup")] = req.bank_index / 4;
-            req.addr_vec[m_dram->m_levels("bank")] = req.bank_index % 4;
+            req.addr_vec[m_dram->m_levels("bankgroup")] = bank_index / 4;
+            req.addr_vec[m_dram->m_levels("bank")] = bank_index % 4;
         }
-        req.addr_vec[m_dram->m_levels("row")] = req.row_addr;
-        req.addr_vec[m_dram->m_levels("column")] = req.col_addr;
+        req.addr_vec[m_dram->m_levels("row")] = row_addr;
+        req.addr_vec[m_dram->m_levels("column")] = col_addr;
     }
 
 public:
@@ -101,6 +413,9 @@ public:
     std::map<Opcode, int> s_num_AiM_requests;
     int s_ISR_queue_full = 0;
     int s_wait_RD_stall = 0;
+    int s_num_issue_width_stalls = 0;
+    int s_num_blocking_ISR_stalls = 0;
+    std::map<GPRHazard, int> s_num_GPR_hazard_stalls;
 
 public:
     void init() override {
@@ -132,26 +447,71 @@ public:
         }
 
         m_clock_ratio = param<uint>("clock_ratio").required();
+        m_skip_ahead = param<bool>("skip_ahead").desc("Skip over cycles in which no component can change its state.").default_val(false);
+        m_num_threads = param<int>("num_threads").desc("Number of threads ticking the channel controllers in parallel (1 ticks them serially).").default_val(1);
+        if ((m_num_threads < 1) || (m_num_threads > num_channels)) {
+            throw ConfigurationError("AiMDRAMSystem: num_threads ({}) must be between 1 and the number of channels ({})!", m_num_threads, num_channels);
+        }
+        m_issue_width = param<int>("issue_width").desc("Number of per-channel requests the DMA can send to the controllers per cycle (0 for unlimited).").default_val(0);
+        if (m_issue_width < 0) {
+            throw ConfigurationError("AiMDRAMSystem: issue_width ({}) must not be negative!", m_issue_width);
+        }
+        m_decode_window = param<int>("decode_window").desc("Number of host requests the DMA can decode ahead of the oldest incomplete one (1 decodes them one at a time).").default_val(1);
+        if (m_decode_window < 1) {
+            throw ConfigurationError("AiMDRAMSystem: decode_window ({}) must be positive!", m_decode_window);
+        }
+        m_num_devices = param<int>("num_devices").desc("Number of AiM devices, which split the channels of the DRAM evenly.").default_val(1);
+        if ((m_num_devices < 1) || (num_channels % m_num_devices != 0)) {
+            throw ConfigurationError("AiMDRAMSystem: num_devices ({}) must be positive and divide the number of channels ({})!", m_num_devices, num_channels);
+        }
+        m_num_device_channels = num_channels / m_num_devices;
+        m_channel_mask_width = (m_num_device_channels + 31) / 32 * 32;
+        m_use_GPR_scoreboard = param<bool>("GPR_scoreboard").desc("Track the GPRs read and written by in-flight host requests instead of blocking the DMA on reads into the GPRs.").default_val(false);
+        m_channel_queues.resize(num_channels);
+
+        // Every device has its own CFRs
+        CFR_values.resize(m_num_devices);
 
         // vector data for MAC is from GB (0) or next bank (1)
         address_to_CFR[0] = CFR::BROADCAST;
-        CFR_values[CFR::BROADCAST] = 0;
+        for (auto &values : CFR_values)
+            values[CFR::BROADCAST] = 0;
 
         // EWMUL in one bank group (0) or all bank groups (1)
         address_to_CFR[1] = CFR::EWMUL_BG;
-        CFR_values[CFR::EWMUL_BG] = 1;
+        for (auto &values : CFR_values)
+            values[CFR::EWMUL_BG] = 1;
 
         // Activation Function mode selects AF (0-7)
         address_to_CFR[2] = CFR::AFM;
-        CFR_values[CFR::AFM] = 0;
+        for (auto &values : CFR_values)
+            values[CFR::AFM] = 0;
 
-        callback = std::bind(&AiMDRAMSystem::receive, this, std::placeholders::_1);
+        m_completions.resize(num_channels);
+        for (int channel_id = 0; channel_id < num_channels; channel_id++) {
+            m_channel_callbacks.push_back([this, channel_id](Request &req) { complete(channel_id, req); });
+        }
 
         register_stat(m_clk).name("memory_system_cycles");
         register_stat(s_wait_RD_stall)
             .name("total_num_wait_read_stalls")
             .desc("total number of cycles that AiM DMA is stalled because of waiting for read operations from channels");
 
+        register_stat(s_num_issue_width_stalls)
+            .name("total_num_issue_width_stalls")
+            .desc("total number of cycles that AiM DMA has requests left to send after using up its issue width");
+
+        register_stat(s_num_blocking_ISR_stalls)
+            .name("total_num_blocking_ISR_stalls")
+            .desc("total number of cycles that AiM DMA does not decode because of waiting for a blocking ISR without a GPR dependency on it");
+
+        for (const auto &[hazard, name] : {std::pair{GPRHazard::RAW, "RAW"}, std::pair{GPRHazard::WAR, "WAR"}, std::pair{GPRHazard::WAW, "WAW"}}) {
+            s_num_GPR_hazard_stalls[hazard] = 0;
+            register_stat(s_num_GPR_hazard_stalls[hazard])
+                .name(fmt::format("total_num_GPR_{}_stalls", name))
+                .desc(fmt::format("total number of cycles that AiM DMA does not decode because of a {} dependency on the GPRs", name));
+        }
+
         register_stat(s_ISR_queue_full)
             .name("total_num_ISR_full")
             .desc("total number of cycles that AiM DMA does not receive ISR because of lack of enough ISR space");
@@ -176,11 +536,28 @@ public:
         }
     };
 
-    void setup(IFrontEnd *frontend, IMemorySystem *memory_system) override {}
+    ~AiMDRAMSystem() {
+        if (m_workers.size() != 0) {
+            m_is_stopping = true;
+            m_tick_barrier->arrive_and_wait();
+            for (auto &worker : m_workers) {
+                worker.join();
+            }
+        }
+    }
+
+    void setup(IFrontEnd *frontend, IMemorySystem *memory_system) override {
+        if (m_num_threads > 1) {
+            m_tick_barrier = std::make_unique<std::barrier<>>(m_num_threads);
+            for (int thread_id = 1; thread_id < m_num_threads; thread_id++) {
+                m_workers.emplace_back(&AiMDRAMSystem::run_worker, this, thread_id);
+            }
+        }
+    }
 
     bool send(Request req) override {
 
-        if (request_queue.size() == ISR_SIZE) {
+        if (request_queue.size() + m_expansions.size() == ISR_SIZE) {
             s_ISR_queue_full++;
             return false;
         }
@@ -206,287 +583,291 @@ public:
         return true;
     };
 
-    void tick() override {
+    /**
+     * @brief    Decodes host_req and queues its per-channel requests to be handed out
+     * 
+     */
+    void decode(const Request &host_req) {
+        // m_logger->info("[CLK {}] Decoding {}...", m_clk, host_req.str());
+        m_expansions.emplace_back();
+        ISRExpansion &expansion = m_expansions.back();
+        expansion.host_req = host_req;
+        expansion.GPR_footprint = get_GPR_footprint(host_req);
+        auto &channel_ids = expansion.channel_ids;
+
+        switch (host_req.type) {
+        case Type::AIM: {
+            const AiMISRPayload &isr = host_req.isr();
+            Opcode opcode = host_req.opcode;
+            auto opsize = isr.opsize;
+            int channel_count = isr.channel_mask.count();
+            Request aim_req = host_req;
+            // The operands of the per-channel requests are in their addr_vec, so they do not share the payload
+            aim_req.payload.reset();
+            if (aim_req.opcode == Opcode::ISR_RD_SBK) {
+                aim_req.type = Type::Read;
+                aim_req.mem_access_region = MemAccessRegion::MEM;
+                aim_req.opcode = Opcode::MIN;
+            } else if (aim_req.opcode == Opcode::ISR_WR_SBK) {
+                aim_req.type = Type::Write;
+                aim_req.mem_access_region = MemAccessRegion::MEM;
+                aim_req.opcode = Opcode::MIN;
+            }
 
-        bool was_AiM_request_remaining = false;
-        bool is_AiM_request_remaining = false;
-        for (int channel_id = 0; channel_id < MAX_CHANNEL_COUNT; channel_id++) {
-            while (remaining_AiM_requests[channel_id].empty() == false) {
-                was_AiM_request_remaining = true;
-                // m_logger->info("[CLK {}] 0- Sending {} to channel {}", m_clk, remaining_AiM_requests[channel_id].front().str(), channel_id);
-                if (m_controllers[channel_id]->send(remaining_AiM_requests[channel_id].front()) == false) {
-                    // m_logger->info("[CLK {}] 0- failed", m_clk, channel_id);
-                    is_AiM_request_remaining = true;
-                    break;
+            switch (opcode) {
+
+            case Opcode::ISR_WR_SBK:
+            case Opcode::ISR_WR_GB:
+            case Opcode::ISR_WR_BIAS:
+            case Opcode::ISR_RD_MAC:
+            case Opcode::ISR_RD_AF:
+            case Opcode::ISR_RD_SBK:
+            case Opcode::ISR_COPY_BKGB:
+            case Opcode::ISR_COPY_GBBK:
+            case Opcode::ISR_MAC_SBK:
+            case Opcode::ISR_MAC_ABK:
+            case Opcode::ISR_AF:
+            case Opcode::ISR_EWMUL:
+            case Opcode::ISR_WR_ABK: {
+                // Decoding opcode
+                const AiMISR &aim_ISR = AiMISRInfo::convert_AiM_opcode_to_AiM_ISR(opcode);
+
+                if (aim_ISR.channel_count_eq_one) {
+                    if (channel_count != 1) {
+                        throw ConfigurationError("AiMDRAMSystem: channel mask ({}) of ISR_WR_SBK must specify only 1 channel!", isr.channel_mask.str());
+                    }
                 }
-                remaining_AiM_requests[channel_id].pop();
-            }
-        }
 
-        if (stalled_AiM_requests == 0) {
-            if (was_AiM_request_remaining == true) {
-                if (is_AiM_request_remaining == false) {
-                    Request host_req = request_queue.front();
-                    if (host_req.callback)
-                        host_req.callback(host_req);
-                    request_queue.pop();
+                int row_addr = isr.row_addr;
+                if (opcode == Opcode::ISR_AF) {
+                    // The activation function mode selects the AF row
+                    row_addr = (1 << 29) + CFR_values[get_device_id(host_req)][CFR::AFM];
                 }
-            } else if (request_queue.empty() == false) {
-                Request host_req = request_queue.front();
-                // m_logger->info("[CLK {}] Decoding {}...", m_clk, host_req.str());
-                bool all_AiM_requests_sent = true;
-
-                switch (host_req.type) {
-                case Type::AIM: {
-                    Opcode opcode = host_req.opcode;
-                    auto opsize = host_req.opsize;
-                    int64_t ch_mask = host_req.channel_mask;
-                    uint8_t channel_count = CountSetBit(ch_mask);
-                    Request aim_req = host_req;
-                    if (aim_req.opcode == Opcode::ISR_RD_SBK) {
-                        aim_req.type = Type::Read;
-                        aim_req.mem_access_region = MemAccessRegion::MEM;
-                        aim_req.opcode = Opcode::MIN;
-                    } else if (aim_req.opcode == Opcode::ISR_WR_SBK) {
-                        aim_req.type = Type::Write;
-                        aim_req.mem_access_region = MemAccessRegion::MEM;
-                        aim_req.opcode = Opcode::MIN;
-                    }
 
-                    switch (opcode) {
-
-                    case Opcode::ISR_WR_SBK:
-                    case Opcode::ISR_WR_GB:
-                    case Opcode::ISR_WR_BIAS:
-                    case Opcode::ISR_RD_MAC:
-                    case Opcode::ISR_RD_AF:
-                    case Opcode::ISR_RD_SBK:
-                    case Opcode::ISR_COPY_BKGB:
-                    case Opcode::ISR_COPY_GBBK:
-                    case Opcode::ISR_MAC_SBK:
-                    case Opcode::ISR_MAC_ABK:
-                    case Opcode::ISR_AF:
-                    case Opcode::ISR_EWMUL:
-                    case Opcode::ISR_WR_ABK: {
-                        // Decoding opcode
-                        AiMISR aim_ISR = AiMISRInfo::convert_AiM_opcode_to_AiM_ISR(opcode);
-
-                        if (aim_ISR.AiM_DMA_blocking) {
-                            aim_req.callback = callback;
-                        }
-
-                        if (aim_ISR.channel_count_eq_one) {
-                            if (channel_count != 1) {
-                                throw ConfigurationError("AiMDRAMSystem: channel mask ({}) of ISR_WR_SBK must specify only 1 channel!", ch_mask);
-                            }
-                        }
-
-                        if (opcode == Opcode::ISR_AF) {
-                            aim_req.afm = CFR_values[CFR::AFM];
-                            aim_req.row_addr = (1 << 29) + aim_req.afm;
-                        }
-
-                        if ((host_req.opcode == Opcode::ISR_MAC_ABK) ||
-                            (host_req.opcode == Opcode::ISR_MAC_SBK)) {
-                            aim_req.broadcast = CFR_values[CFR::BROADCAST];
-                        }
-
-                        if (host_req.opcode == Opcode::ISR_MAC_ABK) {
-                            aim_req.ewmul_bg = CFR_values[CFR::EWMUL_BG];
-                        }
-
-                        if (aim_ISR.is_field_legal(AiMISR::Field::bank_index) == true)
-                            aim_req.bank_index = host_req.bank_index;
-
-                        if (aim_ISR.is_field_legal(AiMISR::Field::row_addr) == true)
-                            aim_req.row_addr = host_req.row_addr;
-
-                        if (opsize == -1)
-                            opsize = 1;
-
-                        if (host_req.col_addr == -1)
-                            host_req.col_addr = 0;
-
-                        for (int i = 0; i < opsize; i++) {
-                            int64_t channel_mask = ch_mask;
-
-                            // if (aim_ISR.is_field_legal(AiMISR::Field::col_addr) == true)
-                            aim_req.col_addr = host_req.col_addr + i;
-
-                            for (int cnt = 0; cnt < channel_count; cnt++) {
-                                uint8_t channel_id = FindFirstChannelIndex(channel_mask);
-
-                                aim_req.AiM_req_id = AiM_req_id++;
-                                aim_req.host_req_id = host_req.host_req_id;
-                                apply_addr_mapp(aim_req, channel_id);
-                                // m_logger->info("[CLK {}] 1- Sending {} to channel {}", m_clk, aim_req.str(), channel_id);
-                                assert(channel_id < m_controllers.size());
-                                assert(channel_id < MAX_CHANNEL_COUNT);
-                                if (m_controllers[channel_id]->send(aim_req) == false) {
-                                    remaining_AiM_requests[channel_id].push(aim_req);
-                                    all_AiM_requests_sent = false;
-                                    // m_logger->info("[CLK {}] 1- failed", aim_req.str(), m_clk, channel_id);
-                                }
-
-                                if (aim_ISR.AiM_DMA_blocking) {
-                                    stalled_AiM_requests += 1;
-                                }
-                            }
-                        }
-
-                        break;
-                    }
+                if (opsize == -1)
+                    opsize = 1;
 
-                    case Opcode::ISR_WR_AFLUT: {
-                        throw ConfigurationError("AiMDRAMSystem: ISR_WR_AFLUT not supported by now!");
-                        break;
-                    }
+                int base_col_addr = (isr.col_addr == -1) ? 0 : isr.col_addr;
 
-                    case Opcode::ISR_EWADD: {
-                        // Do nothing
-                        break;
-                    }
+                add_masked_channels(host_req, channel_ids);
+                // With the scoreboard, reads into the GPRs are waited for by the host requests that use their results only
+                bool writes_GPR = (expansion.GPR_footprint.write.end != expansion.GPR_footprint.write.begin);
+                expansion.is_blocking = aim_ISR.AiM_DMA_blocking && !(m_use_GPR_scoreboard && writes_GPR);
+                start_expansion(expansion, aim_req, isr.bank_index, row_addr, base_col_addr, opsize, aim_ISR.AiM_DMA_blocking || (m_use_GPR_scoreboard && writes_GPR));
+                break;
+            }
 
-                    case Opcode::ISR_SYNC: {
-                        aim_req.callback = callback;
-                        for (int channel_id = 0; channel_id < m_controllers.size(); channel_id++) {
-                            aim_req.AiM_req_id = AiM_req_id++;
-                            aim_req.host_req_id = host_req.host_req_id;
-                            // m_logger->info("[CLK {}] 2- Sending {} to channel {}", m_clk, aim_req.str(), channel_id);
-                            if (m_controllers[channel_id]->send(aim_req) == false) {
-                                remaining_AiM_requests[channel_id].push(aim_req);
-                                all_AiM_requests_sent = false;
-                            }
-                            stalled_AiM_requests += 1;
-                        }
-                        break;
-                    } break;
-
-                    case Opcode::ISR_EOC: {
-                        aim_req.callback = callback;
-                        for (int channel_id = 0; channel_id < m_controllers.size(); channel_id++) {
-                            aim_req.AiM_req_id = AiM_req_id++;
-                            aim_req.host_req_id = host_req.host_req_id;
-                            // m_logger->info("[CLK {}] 3- Sending {} to channel {}", m_clk, aim_req.str(), channel_id);
-                            if (m_controllers[channel_id]->send(aim_req) == false) {
-                                remaining_AiM_requests[channel_id].push(aim_req);
-                                all_AiM_requests_sent = false;
-                            }
-                            stalled_AiM_requests += 1;
-                        }
-                        break;
-                    } break;
-
-                    default:
-                        m_logger->error("unknown command \n");
-                        break;
-                    }
-                } break;
-                case Type::Read: {
-                    switch (host_req.mem_access_region) {
-                    case MemAccessRegion::CFR: {
-                        // Do nothing
-                        all_AiM_requests_sent = true;
-                        break;
-                    }
-                    case MemAccessRegion::GPR: {
-                        // Do nothing
-                        all_AiM_requests_sent = true;
-                        break;
-                    }
-                    case MemAccessRegion::MEM: {
-                        Request aim_req = host_req;
-                        // aim_req.callback = callback;
-                        aim_req.AiM_req_id = AiM_req_id++;
-                        apply_addr_mapp(aim_req, aim_req.channel_mask);
-                        int channel_id = aim_req.addr_vec[m_dram->m_levels("channel")];
-                        // m_logger->info("[CLK {}] 4- Sending {} to channel {}", m_clk, aim_req.str(), channel_id);
-                        if (m_controllers[channel_id]->send(aim_req) == false) {
-                            remaining_AiM_requests[channel_id].push(aim_req);
-                            all_AiM_requests_sent = false;
-                        }
-                        // stalled_AiM_requests += 1;
-                        break;
-                    }
-                    default: {
-                        throw ConfigurationError("AiMDRAMSystem: memory access region {}!", (int)host_req.mem_access_region);
-                        break;
-                    }
-                    }
-                    break;
-                }
-                case Type::Write: {
-                    switch (host_req.mem_access_region) {
-                    case MemAccessRegion::CFR: {
-                        if (address_to_CFR.find(host_req.addr) == address_to_CFR.end()) {
-                            throw ConfigurationError("AiMDRAMSystem: unknown CFR at location {}!", (int)host_req.addr);
-                        }
-                        CFR_values[address_to_CFR[host_req.addr]] = host_req.data;
-                        all_AiM_requests_sent = true;
-                        break;
-                    }
-                    case MemAccessRegion::GPR: {
-                        // Do nothing
-                        all_AiM_requests_sent = true;
-                        break;
-                    }
-                    case MemAccessRegion::MEM: {
-                        Request aim_req = host_req;
-                        aim_req.AiM_req_id = AiM_req_id++;
-                        apply_addr_mapp(aim_req, aim_req.channel_mask);
-                        int channel_id = aim_req.addr_vec[m_dram->m_levels("channel")];
-                        // m_logger->info("[CLK {}] 5- Sending {} to channel {}, channel_mask {}", m_clk, aim_req.str(), channel_id, aim_req.channel_mask);
-                        if (m_controllers[channel_id]->send(aim_req) == false) {
-                            remaining_AiM_requests[channel_id].push(aim_req);
-                            all_AiM_requests_sent = false;
-                            // m_logger->info("[CLK {}] 4- failed", aim_req.str(), m_clk, channel_id, aim_req.channel_mask);
-                        } else {
-                            // m_logger->info("[CLK {}] 4- sent", aim_req.str(), m_clk, channel_id, aim_req.channel_mask);
-                        }
-                        break;
-                    }
-                    default: {
-                        throw ConfigurationError("AiMDRAMSystem: memory access region {}!", (int)host_req.mem_access_region);
-                        break;
-                    }
-                    }
-                    break;
-                }
-                default: {
-                    throw ConfigurationError("AiMDRAMSystem: unknown request type {}!", (int)host_req.type);
-                    break;
+            case Opcode::ISR_WR_AFLUT: {
+                throw ConfigurationError("AiMDRAMSystem: ISR_WR_AFLUT not supported by now!");
+                break;
+            }
+
+            case Opcode::ISR_EWADD: {
+                // Do nothing
+                break;
+            }
+
+            case Opcode::ISR_SYNC:
+            case Opcode::ISR_EOC: {
+                // Without a device, a barrier for all the devices
+                bool is_for_all_devices = (isr.device_id == -1);
+                int first_channel_id = is_for_all_devices ? 0 : get_device_id(host_req) * m_num_device_channels;
+                int num_channels = is_for_all_devices ? m_controllers.size() : m_num_device_channels;
+                for (int channel_id = first_channel_id; channel_id < first_channel_id + num_channels; channel_id++) {
+                    channel_ids.push_back(channel_id);
                 }
+                expansion.is_blocking = true;
+                start_expansion(expansion, aim_req, -1, -1, -1, 1, true);
+                break;
+            }
+
+            default:
+                m_logger->error("unknown command \n");
+                break;
+            }
+        } break;
+        case Type::Read: {
+            switch (host_req.mem_access_region) {
+            case MemAccessRegion::CFR: {
+                // Do nothing
+                break;
+            }
+            case MemAccessRegion::GPR: {
+                // Do nothing
+                break;
+            }
+            case MemAccessRegion::MEM: {
+                const AiMISRPayload &isr = host_req.isr();
+                Request aim_req = host_req;
+                aim_req.payload.reset();
+                // aim_req.callback = callback;
+                channel_ids.push_back(get_MEM_channel_id(host_req));
+                start_expansion(expansion, aim_req, isr.bank_index, isr.row_addr, isr.col_addr, 1, false);
+                break;
+            }
+            default: {
+                throw ConfigurationError("AiMDRAMSystem: memory access region {}!", (int)host_req.mem_access_region);
+                break;
+            }
+            }
+            break;
+        }
+        case Type::Write: {
+            switch (host_req.mem_access_region) {
+            case MemAccessRegion::CFR: {
+                if (address_to_CFR.find(host_req.addr) == address_to_CFR.end()) {
+                    throw ConfigurationError("AiMDRAMSystem: unknown CFR at location {}!", (int)host_req.addr);
                 }
-                if ((stalled_AiM_requests == 0) && (all_AiM_requests_sent == true)) {
-                    if (host_req.callback)
-                        host_req.callback(host_req);
-                    request_queue.pop();
+                CFR_values[get_device_id(host_req)][address_to_CFR[host_req.addr]] = host_req.data;
+                break;
+            }
+            case MemAccessRegion::GPR: {
+                // Do nothing
+                break;
+            }
+            case MemAccessRegion::MEM: {
+                const AiMISRPayload &isr = host_req.isr();
+                Request aim_req = host_req;
+                aim_req.payload.reset();
+                channel_ids.push_back(get_MEM_channel_id(host_req));
+                start_expansion(expansion, aim_req, isr.bank_index, isr.row_addr, isr.col_addr, 1, false);
+                break;
+            }
+            default: {
+                throw ConfigurationError("AiMDRAMSystem: memory access region {}!", (int)host_req.mem_access_region);
+                break;
+            }
+            }
+            break;
+        }
+        default: {
+            throw ConfigurationError("AiMDRAMSystem: unknown request type {}!", (int)host_req.type);
+            break;
+        }
+        }
+
+        m_num_blocking_expansions += expansion.is_blocking;
+    }
+
+    void tick() override {
+
+        m_is_DMA_active = false;
+        m_num_issued = 0;
+        // A slot freed in this cycle can only be decoded into in the next one
+        bool has_free_slot = (m_expansions.size() < m_decode_window);
+
+        if (m_num_unsent_requests != 0) {
+            m_is_DMA_active = expand();
+            retire_completed();
+        }
+
+        if (has_free_slot && (request_queue.empty() == false)) {
+            // A stall is counted as a true dependency if the scoreboard alone would have stalled too
+            GPRHazard hazard = get_GPR_hazard(get_GPR_footprint(request_queue.front()));
+            if (hazard != GPRHazard::NONE) {
+                s_num_GPR_hazard_stalls[hazard]++;
+            } else if (is_decode_stalled_by_blocking()) {
+                s_num_blocking_ISR_stalls++;
+            } else {
+                m_is_DMA_active = true;
+                decode(request_queue.front());
+                request_queue.pop();
+                if (m_num_unsent_requests != 0) {
+                    expand();
                 }
+                retire_completed();
             }
         }
+        s_num_issue_width_stalls += (m_issue_width != 0) && (m_num_issued == m_issue_width) && (m_num_unsent_requests != 0);
 
         if (m_clk % m_controllers[0]->get_clock_ratio() == 0) {
             m_dram->tick();
-            for (auto controller : m_controllers) {
-                controller->tick();
+            if (m_num_threads == 1) {
+                for (auto controller : m_controllers) {
+                    controller->tick();
+                }
+            } else {
+                // Channels do not interact within a tick: release the workers, tick my own slice, and wait for the rest
+                m_tick_barrier->arrive_and_wait();
+                tick_controllers(0);
+                m_tick_barrier->arrive_and_wait();
+
+                // Apply the completions in channel order, exactly as the serial loop would have
+                for (auto &completions : m_completions) {
+                    for (auto &req : completions) {
+                        receive(req);
+                    }
+                    completions.clear();
+                }
             }
         }
 
         m_clk++;
     };
 
-    void receive(Request &req) {
-        Request host_req = request_queue.front();
-        if (req.host_req_id != host_req.host_req_id)
-            throw ConfigurationError("AiMDRAMSystem: received request id {} != head of the queue request id {}!", req.host_req_id, host_req.host_req_id);
+    Clk_t get_skippable_cycles() override {
+        if (!m_skip_ahead || m_is_DMA_active || m_controllers[0]->get_clock_ratio() != 1) {
+            return 0;
+        }
 
-        stalled_AiM_requests--;
+        // The DMA only waits for the controllers; it can decode the next ISR right away otherwise
+        if (can_decode()) {
+            return 0;
+        }
 
-        if (stalled_AiM_requests == 0) {
-            if (host_req.callback)
-                host_req.callback(host_req);
-            request_queue.pop();
+        Clk_t skippable_cycles = std::numeric_limits<Clk_t>::max();
+        for (auto controller : m_controllers) {
+            skippable_cycles = std::min(skippable_cycles, controller->get_skippable_cycles());
+            if (skippable_cycles == 0) {
+                break;
+            }
+        }
+        return skippable_cycles;
+    };
+
+    void skip_cycles(Clk_t num_cycles) override {
+        m_dram->skip_cycles(num_cycles);
+        for (auto controller : m_controllers) {
+            controller->skip_cycles(num_cycles);
         }
+        m_clk += num_cycles;
+    };
+
+    void tick_controllers(int thread_id) {
+        int num_channels = m_controllers.size();
+        for (int channel_id = thread_id * num_channels / m_num_threads; channel_id < (thread_id + 1) * num_channels / m_num_threads; channel_id++) {
+            m_controllers[channel_id]->tick();
+        }
+    }
+
+    void run_worker(int thread_id) {
+        while (true) {
+            m_tick_barrier->arrive_and_wait();
+            if (m_is_stopping) {
+                return;
+            }
+            tick_controllers(thread_id);
+            m_tick_barrier->arrive_and_wait();
+        }
+    }
+
+    void complete(int channel_id, Request &req) {
+        if (m_num_threads == 1) {
+            receive(req);
+        } else {
+            // Called from the thread ticking this channel; the DMA state is only updated after the barrier
+            m_completions[channel_id].push_back(req);
+        }
+    }
+
+    void receive(Request &req) {
+        auto expansion = std::find_if(m_expansions.begin(), m_expansions.end(),
+                                      [&req](const ISRExpansion &expansion) { return expansion.host_req.host_req_id == req.host_req_id; });
+        if (expansion == m_expansions.end())
+            throw ConfigurationError("AiMDRAMSystem: received request id {} that is not in flight!", req.host_req_id);
+
+        expansion->num_pending--;
+        retire_completed();
     }
 
     float get_tCK() override {
@@ -56,6 +56,21 @@ public:
      */
     virtual void tick() = 0;
 
+    /**
+     * @brief    Returns how many upcoming ticks are guaranteed to not change any state
+     * @details
+     * Called after tick(). A non-zero value lets the top-level loop jump over cycles in which
+     * every component is only waiting on timing constraints, refreshes, or in-flight requests.
+     * 
+     */
+    virtual Clk_t get_skippable_cycles() { return 0; };
+
+    /**
+     * @brief    Advances the memory system by num_cycles without ticking it
+     * 
+     */
+    virtual void skip_cycles(Clk_t num_cycles) {};
+
     /**
      * @brief    Returns 
      * 
@@ -7,3 +7,6 @@
 ./build/ramulator2 -f test/example.yaml -t test/micro_wrbias_mac_af_rdaf_16banks.trace &> test/micro_wrbias_mac_af_rdaf_16banks.result
 ./build/ramulator2 -f test/example.yaml -t test/micro_wrbias_mac_rdmac_mac_16banks.trace &> test/micro_wrbias_mac_rdmac_mac_16banks.result
 ./build/ramulator2 -f test/example.yaml -t test/micro_wrgb_gbbk_bggb_16banks.trace &> test/micro_wrgb_gbbk_bggb_16banks.result
+./build/ramulator2 -f test/gpr_scoreboard.yaml -t test/gpr_scoreboard.trace &> test/gpr_scoreboard.result
+./build/ramulator2 -f test/gpr_scoreboard.yaml -t test/micro_wrbias_mac_rdmac_mac_16banks.trace &> test/micro_wrbias_mac_rdmac_mac_16banks_gpr_scoreboard.result
+./build/ramulator2 -f test/multi_device.yaml -t test/multi_device.trace &> test/multi_device.result